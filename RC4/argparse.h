@@ -0,0 +1,28 @@
+#ifndef ARGPARSE_H
+#define ARGPARSE_H
+
+// Checked parsing of numeric command-line arguments. stoul and friends throw on a typo
+// such as "x10" (ending the tool with an uncaught exception) and quietly take the "10"
+// of "10x"; the tools print their usage instead.
+
+#include <cstdint>
+#include <string>
+#include <limits>
+
+// Function to parse a non-negative decimal argument of at most max; false unless the whole
+// text is such a number
+template <typename T>
+inline bool parseUnsigned(const std::string &text, T &value, T max = std::numeric_limits<T>::max()) {
+    if (text.empty()) return false;
+    T parsed = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        T digit = c - '0';
+        if (parsed > (max - digit) / 10) return false;
+        parsed = parsed * 10 + digit;
+    }
+    value = parsed;
+    return true;
+}
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef CHACHA20_H
+#define CHACHA20_H
+
+// ChaCha20 (RFC 8439: 256-bit key, 96-bit nonce, 32-bit block counter) behind the
+// StreamCipher interface. Unlike the RC4 PRGA every 64-byte block is independent, so
+// the AVX2 kernel computes 8 blocks per iteration (one block per 32-bit lane, one
+// register per state word) and the AVX-512 kernel 16. The kernel is picked at runtime
+// from the CPU features; partial blocks and the tail go through the scalar code.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "streamcipher.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHACHA20_X86 1
+#endif
+
+enum class ChaChaKernel { Scalar, Avx2, Avx512 };
+
+inline ChaChaKernel chachaBestKernel() {
+#ifdef CHACHA20_X86
+    static const ChaChaKernel kernel = __builtin_cpu_supports("avx512f") ? ChaChaKernel::Avx512
+                                     : __builtin_cpu_supports("avx2") ? ChaChaKernel::Avx2
+                                     : ChaChaKernel::Scalar;
+    return kernel;
+#else
+    return ChaChaKernel::Scalar;
+#endif
+}
+
+inline uint32_t chachaLoad32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+inline uint32_t chachaRotl(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+#define CHACHA_QUARTERROUND(a, b, c, d) \
+    a += b; d ^= a; d = chachaRotl(d, 16); \
+    c += d; b ^= c; b = chachaRotl(b, 12); \
+    a += b; d ^= a; d = chachaRotl(d, 8);  \
+    c += d; b ^= c; b = chachaRotl(b, 7);
+
+// Function to compute one 64-byte keystream block for the given input state
+inline void chachaBlock(const uint32_t state[16], uint8_t out[64]) {
+    uint32_t x[16];
+    memcpy(x, state, sizeof(x));
+    for (int round = 0; round < 10; round++) {
+        CHACHA_QUARTERROUND(x[0], x[4], x[8], x[12])
+        CHACHA_QUARTERROUND(x[1], x[5], x[9], x[13])
+        CHACHA_QUARTERROUND(x[2], x[6], x[10], x[14])
+        CHACHA_QUARTERROUND(x[3], x[7], x[11], x[15])
+        CHACHA_QUARTERROUND(x[0], x[5], x[10], x[15])
+        CHACHA_QUARTERROUND(x[1], x[6], x[11], x[12])
+        CHACHA_QUARTERROUND(x[2], x[7], x[8], x[13])
+        CHACHA_QUARTERROUND(x[3], x[4], x[9], x[14])
+    }
+    for (int w = 0; w < 16; w++) {
+        uint32_t v = x[w] + state[w];
+        out[4 * w] = v;
+        out[4 * w + 1] = v >> 8;
+        out[4 * w + 2] = v >> 16;
+        out[4 * w + 3] = v >> 24;
+    }
+}
+
+#undef CHACHA_QUARTERROUND
+
+#ifdef CHACHA20_X86
+
+// Function to XOR 8 blocks (512 bytes) of keystream into in, counters state[12] .. state[12] + 7
+__attribute__((target("avx2")))
+inline void chachaBlocksAvx2(const uint32_t state[16], const uint8_t *in, uint8_t *out) {
+    const __m256i rot16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                           2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                          3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    __m256i orig[16], x[16];
+    for (int w = 0; w < 16; w++) {
+        orig[w] = _mm256_set1_epi32(state[w]);
+    }
+    orig[12] = _mm256_add_epi32(orig[12], _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    for (int w = 0; w < 16; w++) {
+        x[w] = orig[w];
+    }
+
+#define QR(a, b, c, d)                                                                                  \
+    x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = _mm256_shuffle_epi8(_mm256_xor_si256(x[d], x[a]), rot16); \
+    x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = _mm256_xor_si256(x[b], x[c]);                            \
+    x[b] = _mm256_or_si256(_mm256_slli_epi32(x[b], 12), _mm256_srli_epi32(x[b], 20));                    \
+    x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = _mm256_shuffle_epi8(_mm256_xor_si256(x[d], x[a]), rot8);  \
+    x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = _mm256_xor_si256(x[b], x[c]);                            \
+    x[b] = _mm256_or_si256(_mm256_slli_epi32(x[b], 7), _mm256_srli_epi32(x[b], 25));
+    for (int round = 0; round < 10; round++) {
+        QR(0, 4, 8, 12) QR(1, 5, 9, 13) QR(2, 6, 10, 14) QR(3, 7, 11, 15)
+        QR(0, 5, 10, 15) QR(1, 6, 11, 12) QR(2, 7, 8, 13) QR(3, 4, 9, 14)
+    }
+#undef QR
+
+    for (int w = 0; w < 16; w++) {
+        x[w] = _mm256_add_epi32(x[w], orig[w]);
+    }
+
+    // Transpose each group of 8 word-vectors into 32-byte halves of the 8 blocks
+    for (int half = 0; half < 2; half++) {
+        __m256i *v = x + 8 * half;
+        __m256i t0 = _mm256_unpacklo_epi32(v[0], v[1]), t1 = _mm256_unpackhi_epi32(v[0], v[1]);
+        __m256i t2 = _mm256_unpacklo_epi32(v[2], v[3]), t3 = _mm256_unpackhi_epi32(v[2], v[3]);
+        __m256i t4 = _mm256_unpacklo_epi32(v[4], v[5]), t5 = _mm256_unpackhi_epi32(v[4], v[5]);
+        __m256i t6 = _mm256_unpacklo_epi32(v[6], v[7]), t7 = _mm256_unpackhi_epi32(v[6], v[7]);
+        __m256i u[8] = {
+            _mm256_unpacklo_epi64(t0, t2), _mm256_unpackhi_epi64(t0, t2),
+            _mm256_unpacklo_epi64(t1, t3), _mm256_unpackhi_epi64(t1, t3),
+            _mm256_unpacklo_epi64(t4, t6), _mm256_unpackhi_epi64(t4, t6),
+            _mm256_unpacklo_epi64(t5, t7), _mm256_unpackhi_epi64(t5, t7),
+        };
+        for (int b = 0; b < 4; b++) {
+            __m256i lo = _mm256_permute2x128_si256(u[b], u[b + 4], 0x20);  // block b
+            __m256i hi = _mm256_permute2x128_si256(u[b], u[b + 4], 0x31);  // block b + 4
+            size_t offLo = 64 * b + 32 * half, offHi = 64 * (b + 4) + 32 * half;
+            __m256i inLo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + offLo));
+            __m256i inHi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + offHi));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + offLo), _mm256_xor_si256(inLo, lo));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + offHi), _mm256_xor_si256(inHi, hi));
+        }
+    }
+}
+
+// GCC 12 reports the _mm512_undefined_epi32() pass-through operand inside the AVX-512
+// intrinsics as uninitialized; the operand is never read with a full mask.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+// Function to XOR 16 blocks (1024 bytes) of keystream into in, counters state[12] .. state[12] + 15
+__attribute__((target("avx512f")))
+inline void chachaBlocksAvx512(const uint32_t state[16], const uint8_t *in, uint8_t *out) {
+    __m512i orig[16], x[16];
+    for (int w = 0; w < 16; w++) {
+        orig[w] = _mm512_set1_epi32(state[w]);
+    }
+    orig[12] = _mm512_add_epi32(orig[12], _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    for (int w = 0; w < 16; w++) {
+        x[w] = orig[w];
+    }
+
+#define QR(a, b, c, d)                                                                              \
+    x[a] = _mm512_add_epi32(x[a], x[b]); x[d] = _mm512_rol_epi32(_mm512_xor_si512(x[d], x[a]), 16); \
+    x[c] = _mm512_add_epi32(x[c], x[d]); x[b] = _mm512_rol_epi32(_mm512_xor_si512(x[b], x[c]), 12); \
+    x[a] = _mm512_add_epi32(x[a], x[b]); x[d] = _mm512_rol_epi32(_mm512_xor_si512(x[d], x[a]), 8);  \
+    x[c] = _mm512_add_epi32(x[c], x[d]); x[b] = _mm512_rol_epi32(_mm512_xor_si512(x[b], x[c]), 7);
+    for (int round = 0; round < 10; round++) {
+        QR(0, 4, 8, 12) QR(1, 5, 9, 13) QR(2, 6, 10, 14) QR(3, 7, 11, 15)
+        QR(0, 5, 10, 15) QR(1, 6, 11, 12) QR(2, 7, 8, 13) QR(3, 4, 9, 14)
+    }
+#undef QR
+
+    for (int w = 0; w < 16; w++) {
+        x[w] = _mm512_add_epi32(x[w], orig[w]);
+    }
+
+    // Transpose: after the 32/64-bit unpacks, group g (words 4g..4g+3) holds in vector k the
+    // 128-bit rows of blocks k, k + 4, k + 8 and k + 12; the lane shuffles then gather the
+    // four rows of each block into one register.
+    __m512i rows[4][4];
+    for (int g = 0; g < 4; g++) {
+        __m512i *v = x + 4 * g;
+        __m512i t0 = _mm512_unpacklo_epi32(v[0], v[1]), t1 = _mm512_unpackhi_epi32(v[0], v[1]);
+        __m512i t2 = _mm512_unpacklo_epi32(v[2], v[3]), t3 = _mm512_unpackhi_epi32(v[2], v[3]);
+        rows[g][0] = _mm512_unpacklo_epi64(t0, t2);
+        rows[g][1] = _mm512_unpackhi_epi64(t0, t2);
+        rows[g][2] = _mm512_unpacklo_epi64(t1, t3);
+        rows[g][3] = _mm512_unpackhi_epi64(t1, t3);
+    }
+    for (int k = 0; k < 4; k++) {
+        __m512i a = _mm512_shuffle_i32x4(rows[0][k], rows[1][k], 0x88);
+        __m512i b = _mm512_shuffle_i32x4(rows[2][k], rows[3][k], 0x88);
+        __m512i c = _mm512_shuffle_i32x4(rows[0][k], rows[1][k], 0xDD);
+        __m512i d = _mm512_shuffle_i32x4(rows[2][k], rows[3][k], 0xDD);
+        __m512i blocks[4] = {
+            _mm512_shuffle_i32x4(a, b, 0x88),  // block k
+            _mm512_shuffle_i32x4(c, d, 0x88),  // block k + 4
+            _mm512_shuffle_i32x4(a, b, 0xDD),  // block k + 8
+            _mm512_shuffle_i32x4(c, d, 0xDD),  // block k + 12
+        };
+        for (int q = 0; q < 4; q++) {
+            size_t off = 64 * (k + 4 * q);
+            __m512i data = _mm512_loadu_si512(in + off);
+            _mm512_storeu_si512(out + off, _mm512_xor_si512(data, blocks[q]));
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+// ChaCha20 keystream with streaming update(): leftover keystream from a partial block
+// is kept for the next call, so any chunking gives the same output.
+class ChaCha20Stream : public StreamCipher {
+public:
+    ChaCha20Stream(const uint8_t key[32], const uint8_t nonce[12], uint32_t counter = 0,
+                   ChaChaKernel kernel = chachaBestKernel())
+        : kernel(kernel), used(64) {
+        state[0] = 0x61707865;
+        state[1] = 0x3320646e;
+        state[2] = 0x79622d32;
+        state[3] = 0x6b206574;
+        for (int w = 0; w < 8; w++) {
+            state[4 + w] = chachaLoad32(key + 4 * w);
+        }
+        state[12] = counter;
+        for (int w = 0; w < 3; w++) {
+            state[13 + w] = chachaLoad32(nonce + 4 * w);
+        }
+    }
+
+    void update(const uint8_t *in, uint8_t *out, size_t len) override {
+        // Finish the keystream block left over from the previous call
+        while (len > 0 && used < 64) {
+            *out++ = *in++ ^ keystream[used++];
+            len--;
+        }
+
+#ifdef CHACHA20_X86
+        // The vector kernels add the lane number to the counter, so they stop short of a 32-bit wrap
+        if (kernel == ChaChaKernel::Avx512) {
+            while (len >= 1024 && state[12] <= UINT32_MAX - 16) {
+                chachaBlocksAvx512(state, in, out);
+                state[12] += 16;
+                in += 1024, out += 1024, len -= 1024;
+            }
+        }
+        if (kernel != ChaChaKernel::Scalar) {
+            while (len >= 512 && state[12] <= UINT32_MAX - 8) {
+                chachaBlocksAvx2(state, in, out);
+                state[12] += 8;
+                in += 512, out += 512, len -= 512;
+            }
+        }
+#endif
+
+        while (len > 0) {
+            chachaBlock(state, keystream);
+            nextBlock();
+            size_t take = len < 64 ? len : 64;
+            for (size_t n = 0; n < take; n++) {
+                out[n] = in[n] ^ keystream[n];
+            }
+            used = take;
+            in += take, out += take, len -= take;
+        }
+    }
+
+private:
+    // RFC 8439 leaves counter overflow undefined; past 2^32 blocks (256 GiB) it carries
+    // into the first nonce word like the original 64-bit-counter ChaCha.
+    void nextBlock() {
+        if (++state[12] == 0) state[13]++;
+    }
+
+    uint32_t state[16];
+    ChaChaKernel kernel;
+    uint8_t keystream[64];
+    size_t used;
+};
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef HEXCODEC_H
+#define HEXCODEC_H
+
+// Block hex codec for the RC4 ciphertext format: every byte is written as two
+// uppercase hex digits followed by a space ("3C 1A 13 "). Encoding and the decoding
+// fast path use a nibble lookup table with PSHUFB (SSSE3, 16 bytes per step) or
+// VPSHUFB (AVX2, 32 bytes per step), picked at runtime from the CPU features.
+// Anything that is not in the canonical layout (newlines, single-digit or lowercase
+// tokens, ...) is handled by the scalar token parser, which also rejects malformed tokens.
+
+#include <cstdint>
+#include <cstddef>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEXCODEC_X86 1
+#endif
+
+// Function to encode len bytes into 3 * len characters, scalar version
+inline void hexEncodeScalar(const uint8_t *in, size_t len, char *out) {
+    static const char digits[] = "0123456789ABCDEF";
+    for (size_t n = 0; n < len; n++) {
+        out[3 * n] = digits[in[n] >> 4];
+        out[3 * n + 1] = digits[in[n] & 0x0F];
+        out[3 * n + 2] = ' ';
+    }
+}
+
+// Function to convert one hex digit to its value, or -1 if it is not a hex digit
+inline int hexDigitValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+inline bool hexIsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Function to decode one whitespace-separated token starting at in[*pos] into out. A token
+// must be one or two hex digits; anything else (a corrupted ciphertext file) clears *valid
+// and stops the decoder. Returns false when only whitespace is left or the token is invalid.
+inline bool hexDecodeToken(const char *in, size_t len, size_t *pos, uint8_t *out, bool *valid) {
+    size_t p = *pos;
+    while (p < len && hexIsSpace(in[p])) p++;
+    if (p == len) {
+        *pos = p;
+        return false;
+    }
+
+    unsigned value = 0;
+    size_t digits = 0;
+    int digit;
+    while (p < len && (digit = hexDigitValue(in[p])) >= 0) {
+        value = (value << 4) | digit;
+        digits++;
+        p++;
+    }
+    if (digits == 0 || digits > 2 || (p < len && !hexIsSpace(in[p]))) {
+        *valid = false;
+        *pos = p;
+        return false;
+    }
+    // Also take the separating space so the block decoders can resume at the next token
+    if (p < len && in[p] == ' ') p++;
+    *out = (uint8_t)value;
+    *pos = p;
+    return true;
+}
+
+#ifdef HEXCODEC_X86
+
+// Shuffle masks for 16 bytes <-> 48 characters. Output chunk k holds characters
+// 16k..16k+15; character t is the high digit of byte t/3 when t%3 == 0, the low
+// digit when t%3 == 1 and a space when t%3 == 2.
+alignas(16) static const uint8_t hexEncodeHi[3][16] = {
+    {0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80, 0x05},
+    {0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A, 0x80},
+    {0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80, 0x80},
+};
+alignas(16) static const uint8_t hexEncodeLo[3][16] = {
+    {0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80},
+    {0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A},
+    {0x80, 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80},
+};
+alignas(16) static const uint8_t hexSpaceSel[3][16] = {
+    {0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00},
+    {0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00},
+    {0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00, 0xFF},
+};
+alignas(16) static const uint8_t hexDecodeHi[3][16] = {
+    {0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0B, 0x0E, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0A, 0x0D},
+};
+alignas(16) static const uint8_t hexDecodeLo[3][16] = {
+    {0x01, 0x04, 0x07, 0x0A, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0B, 0x0E},
+};
+
+__attribute__((target("ssse3")))
+inline __m128i hexLoadMask(const uint8_t *mask) {
+    return _mm_load_si128(reinterpret_cast<const __m128i *>(mask));
+}
+
+// Function to encode 16 bytes per step with SSSE3; returns how many bytes were encoded
+__attribute__((target("ssse3")))
+inline size_t hexEncodeSsse3(const uint8_t *in, size_t len, char *out) {
+    const __m128i lut = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i space = _mm_set1_epi8(' ');
+    size_t n = 0;
+    for (; n + 16 <= len; n += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + n));
+        __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, nibble));
+        for (int k = 0; k < 3; k++) {
+            __m128i chunk = _mm_or_si128(_mm_shuffle_epi8(hi, hexLoadMask(hexEncodeHi[k])),
+                                         _mm_shuffle_epi8(lo, hexLoadMask(hexEncodeLo[k])));
+            chunk = _mm_or_si128(chunk, _mm_and_si128(hexLoadMask(hexSpaceSel[k]), space));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 3 * n + 16 * k), chunk);
+        }
+    }
+    return n;
+}
+
+// Function to turn hex digit characters into nibble values; *valid is cleared if any byte is not a hex digit
+__attribute__((target("ssse3")))
+inline __m128i hexNibbles128(__m128i c, bool *valid) {
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i alpha = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+    if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xFFFF) *valid = false;
+    return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                        _mm_and_si128(isAlpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+// Function to decode one canonical 48-character block into 16 bytes with SSSE3; false if the block is not canonical
+__attribute__((target("ssse3")))
+inline bool hexDecodeBlockSsse3(const char *in, uint8_t *out) {
+    const __m128i space = _mm_set1_epi8(' ');
+    __m128i hiChars = _mm_setzero_si128();
+    __m128i loChars = _mm_setzero_si128();
+    bool valid = true;
+    for (int k = 0; k < 3; k++) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 16 * k));
+        __m128i sel = hexLoadMask(hexSpaceSel[k]);
+        __m128i spaces = _mm_cmpeq_epi8(_mm_and_si128(c, sel), _mm_and_si128(space, sel));
+        if (_mm_movemask_epi8(spaces) != 0xFFFF) return false;
+        hiChars = _mm_or_si128(hiChars, _mm_shuffle_epi8(c, hexLoadMask(hexDecodeHi[k])));
+        loChars = _mm_or_si128(loChars, _mm_shuffle_epi8(c, hexLoadMask(hexDecodeLo[k])));
+    }
+    __m128i hi = hexNibbles128(hiChars, &valid);
+    __m128i lo = hexNibbles128(loChars, &valid);
+    if (!valid) return false;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_or_si128(_mm_slli_epi16(hi, 4), lo));
+    return true;
+}
+
+// AVX2 versions: VPSHUFB shuffles within 128-bit lanes, so the low lane handles
+// bytes 0..15 / characters 0..47 and the high lane bytes 16..31 / characters 48..95
+// with the same masks as above.
+__attribute__((target("avx2")))
+inline __m256i hexLoadMask2(const uint8_t *mask) {
+    return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(mask)));
+}
+
+__attribute__((target("avx2")))
+inline size_t hexEncodeAvx2(const uint8_t *in, size_t len, char *out) {
+    const __m256i lut = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+                                         '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i space = _mm256_set1_epi8(' ');
+    size_t n = 0;
+    for (; n + 32 <= len; n += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + n));
+        __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, nibble));
+        for (int k = 0; k < 3; k++) {
+            __m256i chunk = _mm256_or_si256(_mm256_shuffle_epi8(hi, hexLoadMask2(hexEncodeHi[k])),
+                                            _mm256_shuffle_epi8(lo, hexLoadMask2(hexEncodeLo[k])));
+            chunk = _mm256_or_si256(chunk, _mm256_and_si256(hexLoadMask2(hexSpaceSel[k]), space));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 3 * n + 16 * k), _mm256_castsi256_si128(chunk));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 3 * n + 48 + 16 * k), _mm256_extracti128_si256(chunk, 1));
+        }
+    }
+    return n;
+}
+
+__attribute__((target("avx2")))
+inline __m256i hexNibbles256(__m256i c, bool *valid) {
+    __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i isAlpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+    if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha)) != -1) *valid = false;
+    return _mm256_or_si256(_mm256_and_si256(isDigit, digit),
+                           _mm256_and_si256(isAlpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+}
+
+// Function to decode one canonical 96-character block into 32 bytes with AVX2; false if the block is not canonical
+__attribute__((target("avx2")))
+inline bool hexDecodeBlockAvx2(const char *in, uint8_t *out) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    __m256i hiChars = _mm256_setzero_si256();
+    __m256i loChars = _mm256_setzero_si256();
+    bool valid = true;
+    for (int k = 0; k < 3; k++) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 16 * k));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 48 + 16 * k));
+        __m256i c = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        __m256i sel = hexLoadMask2(hexSpaceSel[k]);
+        __m256i spaces = _mm256_cmpeq_epi8(_mm256_and_si256(c, sel), _mm256_and_si256(space, sel));
+        if (_mm256_movemask_epi8(spaces) != -1) return false;
+        hiChars = _mm256_or_si256(hiChars, _mm256_shuffle_epi8(c, hexLoadMask2(hexDecodeHi[k])));
+        loChars = _mm256_or_si256(loChars, _mm256_shuffle_epi8(c, hexLoadMask2(hexDecodeLo[k])));
+    }
+    __m256i hi = hexNibbles256(hiChars, &valid);
+    __m256i lo = hexNibbles256(loChars, &valid);
+    if (!valid) return false;
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_or_si256(_mm256_slli_epi16(hi, 4), lo));
+    return true;
+}
+
+#endif
+
+// Widest hex kernel supported by the running CPU
+enum class HexKernel { Scalar, Ssse3, Avx2 };
+
+inline HexKernel hexBestKernel() {
+#ifdef HEXCODEC_X86
+    static const HexKernel kernel = __builtin_cpu_supports("avx2") ? HexKernel::Avx2
+                                  : __builtin_cpu_supports("ssse3") ? HexKernel::Ssse3
+                                  : HexKernel::Scalar;
+    return kernel;
+#else
+    return HexKernel::Scalar;
+#endif
+}
+
+// Function to encode len bytes as "HH " triplets; out must hold 3 * len characters
+inline void hexEncode(const uint8_t *in, size_t len, char *out, HexKernel kernel = hexBestKernel()) {
+    size_t done = 0;
+#ifdef HEXCODEC_X86
+    if (kernel == HexKernel::Avx2) done = hexEncodeAvx2(in, len, out);
+    if (kernel != HexKernel::Scalar) done += hexEncodeSsse3(in + done, len - done, out + 3 * done);
+#endif
+    hexEncodeScalar(in + done, len - done, out + 3 * done);
+}
+
+// Function to decode whitespace-separated hex tokens; in must end on a token boundary.
+// out must hold (len + 1) / 2 bytes. Returns the number of bytes decoded; *valid is set to
+// false (and decoding stops) at the first token that is not one or two hex digits.
+inline size_t hexDecode(const char *in, size_t len, uint8_t *out, bool *valid, HexKernel kernel = hexBestKernel()) {
+    size_t pos = 0, n = 0;
+    *valid = true;
+    for (;;) {
+#ifdef HEXCODEC_X86
+        if (kernel == HexKernel::Avx2) {
+            while (pos + 96 <= len && hexDecodeBlockAvx2(in + pos, out + n)) {
+                pos += 96;
+                n += 32;
+            }
+        }
+        if (kernel != HexKernel::Scalar) {
+            while (pos + 48 <= len && hexDecodeBlockSsse3(in + pos, out + n)) {
+                pos += 48;
+                n += 16;
+            }
+        }
+#endif
+        // Not canonical here (or near the end): take one token the slow way and retry
+        if (!hexDecodeToken(in, len, &pos, out + n, valid)) break;
+        n++;
+    }
+    return n;
+}
+
+#endif
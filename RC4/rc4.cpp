@@ -3,97 +3,869 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <string>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <memory>
+#include <array>
+#include "rc4.h"
+#include "hexcodec.h"
+#include "chacha20.h"
+#include "sha256.h"
+#include "argparse.h"
 
 using namespace std;
 
-// Function to initialize the state array and the key array
-void initializeStateAndKey(const vector<uint8_t> &key, vector<uint8_t> &S, vector<uint8_t> &K) {
-    size_t keyLength = key.size();
+// Function to read the content of a file into a vector
+vector<uint8_t> readFile(const string &filename) {
+    ifstream file(filename, ios::binary);
+    return vector<uint8_t>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
 
-    for (int i = 0; i < 256; i++) {
-        S[i] = i;
-        K[i] = key[i % keyLength];
+// Function to write a vector to a file
+void writeFile(const string &filename, const vector<uint8_t> &data) {
+    ofstream file(filename, ios::binary);
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+// Function to create the stream cipher selected with --cipher. RC4 takes the key file as is;
+// ChaCha20 needs a 32-byte key, optionally followed by a 12-byte nonce (zero otherwise).
+unique_ptr<StreamCipher> makeCipher(const string &name, const vector<uint8_t> &key) {
+    if (name == "rc4") {
+        if (key.empty()) {
+            cerr << "Empty or missing key file" << endl;
+            return nullptr;
+        }
+        return unique_ptr<StreamCipher>(new Rc4Stream(key));
     }
+    if (name == "chacha20") {
+        if (key.size() != 32 && key.size() != 44) {
+            cerr << "A ChaCha20 key file must hold a 32-byte key, optionally followed by a 12-byte nonce" << endl;
+            return nullptr;
+        }
+        uint8_t nonce[12] = {};
+        if (key.size() == 44) copy(key.begin() + 32, key.end(), nonce);
+        return unique_ptr<StreamCipher>(new ChaCha20Stream(key.data(), nonce));
+    }
+    cerr << "Unknown cipher " << name << " (expected rc4 or chacha20)" << endl;
+    return nullptr;
+}
 
-    int j = 0;
-    for (int i = 0; i < 256; i++) {
-        j = (j + S[i] + K[i]) % 256;
-        swap(S[i], S[j]);
+// Size of the buffer used by the streaming file functions; memory use stays flat regardless of file size
+const size_t CHUNK_SIZE = 64 * 1024;
+
+// Function to encrypt a file chunk by chunk, writing the ciphertext in hexadecimal format or as raw binary
+void encryptFile(const string &inFilename, const string &outFilename, StreamCipher &cipher, bool raw) {
+    ifstream in(inFilename, ios::binary);
+    ofstream out(outFilename, ios::binary);
+    vector<uint8_t> buffer(CHUNK_SIZE);
+    vector<char> text(3 * CHUNK_SIZE);
+
+    while (in) {
+        in.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+        size_t got = in.gcount();
+        if (got == 0) break;
+        cipher.update(buffer.data(), buffer.data(), got);
+        if (raw) {
+            out.write(reinterpret_cast<const char *>(buffer.data()), got);
+        } else {
+            hexEncode(buffer.data(), got, text.data());
+            out.write(text.data(), 3 * got);
+        }
     }
 }
 
-// Function to encrypt or decrypt the input data using RC4
-vector<uint8_t> rc4EncryptDecrypt(const vector<uint8_t> &input, const vector<uint8_t> &key) {
-    vector<uint8_t> S(256), K(256);
-    initializeStateAndKey(key, S, K);
+// Function to decrypt a hexadecimal (or raw binary) ciphertext file chunk by chunk and write the plaintext;
+// false if the hexadecimal text is malformed
+bool decryptFile(const string &inFilename, const string &outFilename, StreamCipher &cipher, bool raw) {
+    ifstream in(inFilename, ios::binary);
+    ofstream out(outFilename, ios::binary);
+    vector<uint8_t> buffer(CHUNK_SIZE);
+    vector<char> text(CHUNK_SIZE);
+    size_t carried = 0;
 
-    vector<uint8_t> output(input.size());
-    int i = 0, j = 0;
+    while (in) {
+        if (raw) {
+            in.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+            size_t got = in.gcount();
+            cipher.update(buffer.data(), buffer.data(), got);
+            out.write(reinterpret_cast<const char *>(buffer.data()), got);
+            continue;
+        }
 
-    for (size_t n = 0; n < input.size(); n++) {
-        i = (i + 1) % 256;
-        j = (j + S[i]) % 256;
-        swap(S[i], S[j]);
-        uint8_t k = S[(S[i] + S[j]) % 256];
-        output[n] = input[n] ^ k;
+        in.read(text.data() + carried, text.size() - carried);
+        size_t available = carried + in.gcount();
+        // Only decode up to the last whitespace; a token cut by the chunk boundary is carried over
+        size_t complete = available;
+        if (in) {
+            while (complete > 0 && !hexIsSpace(text[complete - 1])) complete--;
+            if (complete == 0) {
+                // A single token longer than the buffer: grow it and keep reading
+                carried = available;
+                text.resize(2 * text.size());
+                buffer.resize(text.size());
+                continue;
+            }
+        }
+        bool valid;
+        size_t got = hexDecode(text.data(), complete, buffer.data(), &valid);
+        if (!valid) {
+            cerr << "Malformed hexadecimal text in " << inFilename << endl;
+            return false;
+        }
+        cipher.update(buffer.data(), buffer.data(), got);
+        out.write(reinterpret_cast<const char *>(buffer.data()), got);
+
+        carried = available - complete;
+        copy(text.begin() + complete, text.begin() + available, text.begin());
     }
+    return true;
+}
 
-    return output;
+// Function to map size bytes of an open file, hinting the kernel that it will be read front to back
+uint8_t *mapFile(int fd, size_t size, int prot) {
+    void *addr = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        cerr << "mmap failed: " << strerror(errno) << endl;
+        return nullptr;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+    return static_cast<uint8_t *>(addr);
 }
 
-// Function to read the content of a file into a vector
-vector<uint8_t> readFile(const string &filename) {
-    ifstream file(filename, ios::binary);
-    return vector<uint8_t>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+// Function to encrypt or decrypt a file through memory mappings, with no intermediate buffers.
+// When outFilename is empty the input file is transformed in place.
+bool transformMapped(const string &inFilename, const string &outFilename, StreamCipher &cipher) {
+    bool inPlace = outFilename.empty();
+    int inFd = open(inFilename.c_str(), inPlace ? O_RDWR : O_RDONLY);
+    if (inFd < 0) {
+        cerr << "Cannot open " << inFilename << ": " << strerror(errno) << endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(inFd, &st) < 0) {
+        cerr << "Cannot stat " << inFilename << ": " << strerror(errno) << endl;
+        close(inFd);
+        return false;
+    }
+    size_t size = st.st_size;
+
+    int outFd = inFd;
+    if (!inPlace) {
+        outFd = open(outFilename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (outFd < 0 || ftruncate(outFd, size) < 0) {
+            cerr << "Cannot create " << outFilename << ": " << strerror(errno) << endl;
+            close(inFd);
+            if (outFd >= 0) close(outFd);
+            return false;
+        }
+    }
+
+    bool ok = true;
+    // mmap rejects zero-length mappings; an empty file simply stays empty
+    if (size > 0) {
+        uint8_t *in = mapFile(inFd, size, inPlace ? PROT_READ | PROT_WRITE : PROT_READ);
+        uint8_t *out = inPlace ? in : (in ? mapFile(outFd, size, PROT_READ | PROT_WRITE) : nullptr);
+        if (in && out) {
+            cipher.update(in, out, size);
+        } else {
+            ok = false;
+        }
+        if (out && out != in) munmap(out, size);
+        if (in) munmap(in, size);
+    }
+
+    if (!inPlace) close(outFd);
+    close(inFd);
+    return ok;
 }
 
-// Function to write a vector to a file
-void writeFile(const string &filename, const vector<uint8_t> &data) {
+// Sidecar checkpoint index: a header followed by one (offset, S, i, j) record every
+// interval bytes of keystream. The records reveal the cipher state, so the index must
+// be protected like the key itself.
+const char INDEX_MAGIC[8] = {'R', 'C', '4', 'I', 'D', 'X', '1', '\0'};
+
+struct Rc4Checkpoint {
+    uint64_t offset;
+    Rc4Stream::State state;
+};
+
+struct Rc4Index {
+    uint64_t interval;
+    vector<Rc4Checkpoint> checkpoints;
+};
+
+// Function to write a checkpoint index to a file
+bool writeIndexFile(const string &filename, const Rc4Index &index) {
     ofstream file(filename, ios::binary);
-    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    uint64_t count = index.checkpoints.size();
+    file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    file.write(reinterpret_cast<const char *>(&index.interval), sizeof(index.interval));
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    for (const Rc4Checkpoint &cp : index.checkpoints) {
+        file.write(reinterpret_cast<const char *>(&cp.offset), sizeof(cp.offset));
+        file.write(reinterpret_cast<const char *>(cp.state.S), sizeof(cp.state.S));
+        file.write(reinterpret_cast<const char *>(&cp.state.i), 1);
+        file.write(reinterpret_cast<const char *>(&cp.state.j), 1);
+    }
+    return static_cast<bool>(file);
+}
+
+// Function to read a checkpoint index from a file; false if it is missing or malformed
+bool readIndexFile(const string &filename, Rc4Index &index) {
+    ifstream file(filename, ios::binary);
+    char magic[sizeof(INDEX_MAGIC)];
+    uint64_t count = 0;
+    if (!file.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), INDEX_MAGIC)) return false;
+    file.read(reinterpret_cast<char *>(&index.interval), sizeof(index.interval));
+    file.read(reinterpret_cast<char *>(&count), sizeof(count));
+    if (!file || index.interval == 0) return false;
+
+    index.checkpoints.clear();
+    for (uint64_t n = 0; n < count; n++) {
+        Rc4Checkpoint cp;
+        file.read(reinterpret_cast<char *>(&cp.offset), sizeof(cp.offset));
+        file.read(reinterpret_cast<char *>(cp.state.S), sizeof(cp.state.S));
+        file.read(reinterpret_cast<char *>(&cp.state.i), 1);
+        file.read(reinterpret_cast<char *>(&cp.state.j), 1);
+        if (!file) return false;
+        index.checkpoints.push_back(cp);
+    }
+    return true;
+}
+
+// Function to encrypt a file to raw binary while snapshotting the cipher state every interval bytes
+bool encryptFileIndexed(const string &inFilename, const string &outFilename, const string &indexFilename,
+                        const vector<uint8_t> &key, uint64_t interval) {
+    ifstream in(inFilename, ios::binary);
+    ofstream out(outFilename, ios::binary);
+    if (!in || !out) {
+        cerr << "Cannot open " << (!in ? inFilename : outFilename) << endl;
+        return false;
+    }
+
+    Rc4Stream rc4(key);
+    Rc4Index index{interval, {}};
+    vector<uint8_t> buffer(CHUNK_SIZE);
+    uint64_t position = 0;
+
+    while (in) {
+        if (position % interval == 0) {
+            index.checkpoints.push_back({position, rc4.save()});
+        }
+        // Never read across a checkpoint boundary
+        size_t want = min<uint64_t>(buffer.size(), interval - position % interval);
+        in.read(reinterpret_cast<char *>(buffer.data()), want);
+        size_t got = in.gcount();
+        if (got == 0) break;
+        rc4.update(buffer.data(), buffer.data(), got);
+        out.write(reinterpret_cast<const char *>(buffer.data()), got);
+        position += got;
+    }
+    // The index must only describe ciphertext that really reached the disk
+    out.close();
+    if (in.bad() || !out) {
+        cerr << "I/O error while encrypting " << inFilename << " to " << outFilename << endl;
+        return false;
+    }
+    return writeIndexFile(indexFilename, index);
+}
+
+// Function to decrypt len bytes starting at offset of a raw ciphertext file. The keystream
+// is resumed from the nearest checkpoint at or before offset, or replayed from byte 0
+// when no index is available. A range running past the end of the file is cut short there;
+// an offset past the end, or a failed read, is an error.
+bool decryptRange(const string &cipherFilename, const string &indexFilename, const vector<uint8_t> &key,
+                  uint64_t offset, size_t len, vector<uint8_t> &data) {
+    ifstream in(cipherFilename, ios::binary | ios::ate);
+    if (!in) {
+        cerr << "Cannot open " << cipherFilename << endl;
+        return false;
+    }
+    uint64_t size = in.tellg();
+    if (offset > size) {
+        cerr << "Offset " << offset << " is past the end of " << cipherFilename << " (" << size << " bytes)" << endl;
+        return false;
+    }
+    len = min<uint64_t>(len, size - offset);
+
+    Rc4Stream rc4(key);
+    uint64_t position = 0;
+
+    Rc4Index index;
+    if (!indexFilename.empty() && readIndexFile(indexFilename, index)) {
+        // Checkpoints are written in order, one per interval
+        uint64_t slot = offset / index.interval;
+        if (slot >= index.checkpoints.size()) slot = index.checkpoints.size() - 1;
+        if (!index.checkpoints.empty() && index.checkpoints[slot].offset <= offset) {
+            rc4.restore(index.checkpoints[slot].state);
+            position = index.checkpoints[slot].offset;
+        }
+    }
+    rc4.discard(offset - position);
+
+    data.resize(len);
+    if (!in.seekg(offset) || !in.read(reinterpret_cast<char *>(data.data()), len)) {
+        cerr << "Cannot read " << len << " bytes at offset " << offset << " of " << cipherFilename << endl;
+        return false;
+    }
+    rc4.update(data.data(), data.data(), data.size());
+    return true;
 }
 
-// Function to write data in hexadecimal format to a file
-void writeHexFile(const string &filename, const vector<uint8_t> &data) {
-    ofstream file(filename);
-    for (uint8_t byte : data) {
-        file << hex << uppercase << setfill('0') << setw(2) << (int)byte << " ";
+// Blocking FIFO used to hand buffers between the pipeline threads
+template <typename T>
+class BlockingQueue {
+public:
+    void push(T item) {
+        {
+            lock_guard<mutex> lock(m);
+            items.push_back(item);
+        }
+        ready.notify_one();
+    }
+
+    T pop() {
+        unique_lock<mutex> lock(m);
+        ready.wait(lock, [this] { return !items.empty(); });
+        T item = items.front();
+        items.pop_front();
+        return item;
     }
-    file.close();
+
+private:
+    mutex m;
+    condition_variable ready;
+    deque<T> items;
+};
+
+// Function to read up to len bytes, retrying short reads; returns -1 on error
+ssize_t readFull(int fd, uint8_t *data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t got = read(fd, data + done, len - done);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) return -1;
+        if (got == 0) break;
+        done += got;
+    }
+    return done;
+}
+
+// Function to write all len bytes; false on error
+bool writeFull(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t put = write(fd, data, len);
+        if (put < 0 && errno == EINTR) continue;
+        if (put < 0) return false;
+        data += put;
+        len -= put;
+    }
+    return true;
 }
 
-// Function to read hexadecimal data from a file and convert it to binary
-vector<uint8_t> readHexFile(const string &filename) {
+// Function to encrypt or decrypt a file with reading, the cipher and writing running on three
+// threads at once. They pass a fixed ring of reusable buffers around: reader -> cipher ->
+// writer -> back to the reader. A zero-length block marks the end of the stream.
+bool transformPipelined(const string &inFilename, const string &outFilename, StreamCipher &cipher,
+                        size_t bufferCount, size_t bufferSize) {
+    int inFd = open(inFilename.c_str(), O_RDONLY);
+    if (inFd < 0) {
+        cerr << "Cannot open " << inFilename << ": " << strerror(errno) << endl;
+        return false;
+    }
+    int outFd = open(outFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outFd < 0) {
+        cerr << "Cannot create " << outFilename << ": " << strerror(errno) << endl;
+        close(inFd);
+        return false;
+    }
+    posix_fadvise(inFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    struct Block {
+        size_t buffer;
+        size_t length;
+    };
+    vector<vector<uint8_t>> buffers(bufferCount, vector<uint8_t>(bufferSize));
+    BlockingQueue<Block> freeBlocks, readBlocks, cipheredBlocks;
+    for (size_t b = 0; b < bufferCount; b++) {
+        freeBlocks.push({b, 0});
+    }
+    atomic<bool> failed(false);
+
+    thread reader([&] {
+        for (;;) {
+            Block block = freeBlocks.pop();
+            ssize_t got = failed ? 0 : readFull(inFd, buffers[block.buffer].data(), bufferSize);
+            if (got < 0) {
+                cerr << "Read failed: " << strerror(errno) << endl;
+                failed = true;
+                got = 0;
+            }
+            block.length = got;
+            readBlocks.push(block);
+            if (got == 0) break;
+        }
+    });
+
+    thread transformer([&] {
+        for (;;) {
+            Block block = readBlocks.pop();
+            uint8_t *data = buffers[block.buffer].data();
+            cipher.update(data, data, block.length);
+            cipheredBlocks.push(block);
+            if (block.length == 0) break;
+        }
+    });
+
+    thread writer([&] {
+        for (;;) {
+            Block block = cipheredBlocks.pop();
+            if (block.length == 0) break;
+            if (!failed && !writeFull(outFd, buffers[block.buffer].data(), block.length)) {
+                cerr << "Write failed: " << strerror(errno) << endl;
+                failed = true;
+            }
+            freeBlocks.push(block);
+        }
+    });
+
+    reader.join();
+    transformer.join();
+    writer.join();
+    close(inFd);
+    if (close(outFd) < 0) failed = true;
+    return !failed;
+}
+
+// Function to move all len bytes of data into a pipe by mapping its pages instead of copying them.
+// The pipe keeps referencing the pages until the reader consumes them, so data must not be
+// overwritten before then; false with errno set on error.
+bool vmspliceFull(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        struct iovec iov = {const_cast<uint8_t *>(data), len};
+        ssize_t put = vmsplice(fd, &iov, 1, 0);
+        if (put < 0 && errno == EINTR) continue;
+        if (put < 0) return false;
+        data += put;
+        len -= put;
+    }
+    return true;
+}
+
+// Statistics of a --pipe run, reported on stderr since stdout carries the data
+struct PipeStats {
+    uint64_t bytes = 0;
+    double seconds = 0;
+    bool spliced = false;
+};
+
+// Function to encrypt or decrypt stdin to stdout in chunks of chunkSize bytes. When stdout is a
+// pipe, chunks are handed over with vmsplice from a ring of page-aligned buffers. A buffer is only
+// refilled after at least a pipe's worth of later chunks went in, so the reader has consumed its
+// pages by then (a reader that splices them on to another pipe could still see them change).
+bool transformStdio(StreamCipher &cipher, size_t chunkSize, PipeStats &stats) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    chunkSize = (chunkSize + page - 1) / page * page;
+
+    struct stat st;
+    stats.spliced = fstat(STDOUT_FILENO, &st) == 0 && S_ISFIFO(st.st_mode);
+    size_t bufferCount = 1;
+    if (stats.spliced) {
+        fcntl(STDOUT_FILENO, F_SETPIPE_SZ, chunkSize);  // best effort; may exceed pipe-max-size
+        int pipeSize = fcntl(STDOUT_FILENO, F_GETPIPE_SZ);
+        bufferCount = (max(pipeSize, 0) + chunkSize - 1) / chunkSize + 1;
+    }
+    void *mapped = mmap(nullptr, bufferCount * chunkSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        cerr << "Cannot allocate buffers: " << strerror(errno) << endl;
+        return false;
+    }
+    uint8_t *buffers = static_cast<uint8_t *>(mapped);
+
+    bool ok = true;
+    auto start = chrono::steady_clock::now();
+    for (size_t b = 0;; b = (b + 1) % bufferCount) {
+        uint8_t *data = buffers + b * chunkSize;
+        ssize_t got = readFull(STDIN_FILENO, data, chunkSize);
+        if (got < 0) {
+            cerr << "Read failed: " << strerror(errno) << endl;
+            ok = false;
+            break;
+        }
+        if (got == 0) break;
+        cipher.update(data, data, got);
+
+        bool put = stats.spliced ? vmspliceFull(STDOUT_FILENO, data, got) : writeFull(STDOUT_FILENO, data, got);
+        if (!put && stats.spliced && errno == EINVAL && stats.bytes == 0) {
+            // vmsplice is not supported on this pipe; fall back to plain writes
+            stats.spliced = false;
+            put = writeFull(STDOUT_FILENO, data, got);
+        }
+        if (!put) {
+            cerr << "Write failed: " << strerror(errno) << endl;
+            ok = false;
+            break;
+        }
+        stats.bytes += got;
+        if ((size_t)got < chunkSize) break;
+    }
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    munmap(mapped, bufferCount * chunkSize);
+    return ok;
+}
+
+// One file of a batch run
+struct BatchJob {
+    string keyFile, inFile, outFile;
+    string keyLabel;  // --batch-dir: relative path the file's key is derived from (deriveFileKey)
+    uint64_t bytes = 0;
+    double seconds = 0;
+    bool ok = false;
+};
+
+// Function to read a batch manifest: one "<key_file> <input_file> <output_file>" per line
+bool readManifest(const string &filename, vector<BatchJob> &jobs) {
     ifstream file(filename);
-    vector<uint8_t> binaryData;
-    string hexByte;
-    
-    while (file >> hexByte) {
-        uint8_t byte = (uint8_t)stoi(hexByte, nullptr, 16);
-        binaryData.push_back(byte);
+    if (!file) {
+        cerr << "Cannot open " << filename << endl;
+        return false;
+    }
+    string line;
+    while (getline(file, line)) {
+        istringstream fields(line);
+        BatchJob job;
+        if (!(fields >> job.keyFile)) continue;
+        if (!(fields >> job.inFile >> job.outFile)) {
+            cerr << "Bad manifest line: " << line << endl;
+            return false;
+        }
+        jobs.push_back(job);
     }
-    
-    return binaryData;
+    return true;
 }
 
-int main() {
-    // 1. Read key and plaintext from their respective files
-    vector<uint8_t> key = readFile("key.txt");
-    vector<uint8_t> plaintext = readFile("plainText.txt");
+// Function to derive the key of one file of a --batch-dir tree from the tree key and the file's
+// relative path, so that no two files share a keystream (a shared one would leak the XOR of
+// their plaintexts). RC4 uses SHA-256(key || 0 || path) as the file key, not key || path, whose
+// related keys RC4 handles badly; ChaCha20 keeps its key and takes the first 12 bytes of
+// SHA-256(nonce || 0 || path) as the nonce. Keys makeCipher would reject are returned as is.
+vector<uint8_t> deriveFileKey(const string &cipherName, const vector<uint8_t> &key, const string &label) {
+    bool chacha = cipherName == "chacha20";
+    if (key.empty() || (chacha && key.size() != 32 && key.size() != 44)) {
+        return key;
+    }
+    vector<uint8_t> material(chacha ? key.begin() + 32 : key.begin(), key.end());
+    material.push_back(0);
+    material.insert(material.end(), label.begin(), label.end());
+    array<uint8_t, 32> digest = sha256(material);
+    if (!chacha) {
+        return vector<uint8_t>(digest.begin(), digest.end());
+    }
+    vector<uint8_t> fileKey(key.begin(), key.begin() + 32);
+    fileKey.insert(fileKey.end(), digest.begin(), digest.begin() + 12);
+    return fileKey;
+}
 
-    // 2. Encrypt the plaintext and write the ciphertext to cipherText.txt
-    vector<uint8_t> ciphertext = rc4EncryptDecrypt(plaintext, key);
-    writeHexFile("cipherText.txt", ciphertext);
+// Function to list every regular file under inDir, mapped to the same relative path under outDir
+bool listDirectory(const string &keyFile, const string &inDir, const string &outDir, vector<BatchJob> &jobs) {
+    namespace fs = std::filesystem;
+    error_code ec;
+    // Writing into the input tree would truncate each file before it is read
+    if (fs::equivalent(inDir, outDir, ec)) {
+        cerr << "The input and output directories must differ" << endl;
+        return false;
+    }
+    ec.clear();
+    for (fs::recursive_directory_iterator it(inDir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file()) continue;
+        fs::path out = fs::path(outDir) / fs::relative(it->path(), inDir);
+        fs::create_directories(out.parent_path(), ec);
+        if (ec) break;
+        BatchJob job;
+        job.keyFile = keyFile;
+        job.inFile = it->path().string();
+        job.outFile = out.string();
+        job.keyLabel = fs::relative(it->path(), inDir).generic_string();
+        jobs.push_back(job);
+    }
+    if (ec) {
+        cerr << "Cannot walk " << inDir << ": " << ec.message() << endl;
+        return false;
+    }
+    return true;
+}
 
-    cout << "Encryption done! Ciphertext saved to cipherText.txt." << endl;
+// Function to encrypt or decrypt one file to raw binary through the caller's buffer
+bool transformFile(const BatchJob &job, const string &cipherName, vector<uint8_t> &buffer, uint64_t &bytes) {
+    vector<uint8_t> key = readFile(job.keyFile);
+    if (!job.keyLabel.empty()) {
+        key = deriveFileKey(cipherName, key, job.keyLabel);
+    }
+    unique_ptr<StreamCipher> cipher = makeCipher(cipherName, key);
+    if (!cipher) {
+        cerr << "Cannot set up the cipher for " << job.inFile << endl;
+        return false;
+    }
+    // Opening the output would truncate the input if both name the same file
+    error_code ec;
+    if (std::filesystem::equivalent(job.inFile, job.outFile, ec)) {
+        cerr << "Input and output are the same file: " << job.inFile << endl;
+        return false;
+    }
+    int inFd = open(job.inFile.c_str(), O_RDONLY);
+    if (inFd < 0) {
+        cerr << "Cannot open " << job.inFile << ": " << strerror(errno) << endl;
+        return false;
+    }
+    int outFd = open(job.outFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outFd < 0) {
+        cerr << "Cannot create " << job.outFile << ": " << strerror(errno) << endl;
+        close(inFd);
+        return false;
+    }
 
-    // 3. Read key and ciphertext from their respective files
-    vector<uint8_t> ciphertextToDecrypt = readHexFile("cipherText.txt");
-    vector<uint8_t> keyForDecryption = readFile("key.txt");
+    bool ok = true;
+    bytes = 0;
+    for (;;) {
+        ssize_t got = readFull(inFd, buffer.data(), buffer.size());
+        if (got <= 0) {
+            ok = got == 0;
+            break;
+        }
+        cipher->update(buffer.data(), buffer.data(), got);
+        if (!writeFull(outFd, buffer.data(), got)) {
+            ok = false;
+            break;
+        }
+        bytes += got;
+    }
+    close(inFd);
+    if (close(outFd) < 0) ok = false;
+    if (!ok) cerr << "I/O error on " << job.inFile << ": " << strerror(errno) << endl;
+    return ok;
+}
+
+// Function to spread the jobs over a pool of worker threads, each with its own buffer
+// and cipher state, and print total throughput and the per-file latency distribution
+bool runBatch(vector<BatchJob> &jobs, const string &cipherName, size_t workers) {
+    atomic<size_t> next(0);
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> pool;
+    for (size_t w = 0; w < workers; w++) {
+        pool.emplace_back([&] {
+            vector<uint8_t> buffer(CHUNK_SIZE);
+            for (size_t n = next++; n < jobs.size(); n = next++) {
+                auto fileStart = chrono::steady_clock::now();
+                jobs[n].ok = transformFile(jobs[n], cipherName, buffer, jobs[n].bytes);
+                jobs[n].seconds = chrono::duration<double>(chrono::steady_clock::now() - fileStart).count();
+            }
+        });
+    }
+    for (thread &t : pool) {
+        t.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t totalBytes = 0;
+    size_t failures = 0;
+    vector<double> latencies;
+    for (const BatchJob &job : jobs) {
+        totalBytes += job.bytes;
+        failures += !job.ok;
+        latencies.push_back(job.seconds * 1e3);
+    }
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies.empty() ? 0.0 : latencies[(size_t)(p * (latencies.size() - 1))]; };
+
+    cout << fixed << setprecision(3);
+    cout << jobs.size() << " files (" << failures << " failed), " << totalBytes << " bytes in " << seconds << " s on "
+         << workers << " workers: " << setprecision(1) << totalBytes / 1e6 / seconds << " MB/s, "
+         << jobs.size() / seconds << " files/s" << endl;
+    cout << setprecision(3) << "Per-file latency (ms): p50 " << percentile(0.5) << ", p90 " << percentile(0.9)
+         << ", p99 " << percentile(0.99) << ", max " << percentile(1.0) << endl;
+    return failures == 0;
+}
+
+int main(int argc, char *argv[]) {
+    // --cipher <name> selects the stream cipher for every mode; RC4 is the default
+    string cipherName = "rc4";
+    if (argc > 2 && string(argv[1]) == "--cipher") {
+        cipherName = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+
+    // Memory-mapped mode: raw binary in, raw binary out (or in place when no output file is given)
+    if (argc > 1 && string(argv[1]) == "--mmap") {
+        if (argc != 4 && argc != 5) {
+            cerr << "Usage: ./rc4 [--cipher rc4|chacha20] --mmap <key_file> <input_file> [output_file]\n";
+            return 1;
+        }
+        unique_ptr<StreamCipher> cipher = makeCipher(cipherName, readFile(argv[2]));
+        if (!cipher || !transformMapped(argv[3], argc == 5 ? argv[4] : "", *cipher)) {
+            return 1;
+        }
+        cout << "Done! Output written to " << (argc == 5 ? argv[4] : argv[3]) << "." << endl;
+        return 0;
+    }
+
+    // Pipelined mode: raw binary, with reading, the cipher and writing overlapped on three threads
+    if (argc > 1 && string(argv[1]) == "--pipeline") {
+        size_t bufferCount = 8, bufferKiB = 1024;
+        if (argc < 5 || argc > 7 || (argc > 5 && !parseUnsigned(argv[5], bufferCount)) ||
+            (argc > 6 && !parseUnsigned(argv[6], bufferKiB, SIZE_MAX >> 10))) {
+            cerr << "Usage: ./rc4 [--cipher rc4|chacha20] --pipeline <key_file> <input_file> <output_file> [buffers] [buffer_KiB]\n";
+            return 1;
+        }
+        size_t bufferSize = bufferKiB << 10;
+        if (bufferCount == 0 || bufferSize == 0) {
+            cerr << "Need at least one buffer of at least 1 KiB\n";
+            return 1;
+        }
+        unique_ptr<StreamCipher> cipher = makeCipher(cipherName, readFile(argv[2]));
+        if (!cipher) {
+            return 1;
+        }
+        auto start = chrono::steady_clock::now();
+        if (!transformPipelined(argv[3], argv[4], *cipher, bufferCount, bufferSize)) {
+            return 1;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        struct stat st;
+        double megabytes = stat(argv[3], &st) == 0 ? st.st_size / 1e6 : 0;
+        cout << "Done! Output written to " << argv[4] << " (" << fixed << setprecision(3) << seconds << " s, "
+             << setprecision(1) << megabytes / seconds << " MB/s)." << endl;
+        return 0;
+    }
+
+    // Pipe mode: stdin to stdout, e.g. tar c dir | ./rc4 --pipe key.txt | ssh host 'cat > dir.tar.rc4'
+    if (argc > 1 && string(argv[1]) == "--pipe") {
+        size_t chunkKiB = 1024;
+        if ((argc != 3 && argc != 4) || (argc > 3 && !parseUnsigned(argv[3], chunkKiB, SIZE_MAX >> 10))) {
+            cerr << "Usage: ./rc4 [--cipher rc4|chacha20] --pipe <key_file> [chunk_KiB] < input > output\n";
+            return 1;
+        }
+        size_t chunkSize = chunkKiB << 10;
+        if (chunkSize == 0) {
+            cerr << "The chunk size must be at least 1 KiB\n";
+            return 1;
+        }
+        unique_ptr<StreamCipher> cipher = makeCipher(cipherName, readFile(argv[2]));
+        PipeStats stats;
+        if (!cipher || !transformStdio(*cipher, chunkSize, stats)) {
+            return 1;
+        }
+        cerr << "Piped " << stats.bytes << " bytes in " << fixed << setprecision(3) << stats.seconds << " s ("
+             << setprecision(1) << stats.bytes / 1e6 / stats.seconds << " MB/s, "
+             << (stats.spliced ? "vmsplice" : "write") << ")" << endl;
+        return 0;
+    }
+
+    // Batch mode: many files from a manifest or a directory tree, spread over a worker pool
+    if (argc > 1 && (string(argv[1]) == "--batch" || string(argv[1]) == "--batch-dir")) {
+        bool directory = string(argv[1]) == "--batch-dir";
+        int fixedArgs = directory ? 5 : 3;
+        size_t workers = max(1u, thread::hardware_concurrency());
+        if ((argc != fixedArgs && argc != fixedArgs + 1) ||
+            (argc > fixedArgs && !parseUnsigned(argv[fixedArgs], workers))) {
+            cerr << "Usage: ./rc4 [--cipher rc4|chacha20] --batch <manifest_file> [workers]\n"
+                 << "       ./rc4 [--cipher rc4|chacha20] --batch-dir <key_file> <input_dir> <output_dir> [workers]\n";
+            return 1;
+        }
+        if (workers == 0) {
+            cerr << "The worker count must be at least 1\n";
+            return 1;
+        }
+        vector<BatchJob> jobs;
+        bool listed = directory ? listDirectory(argv[2], argv[3], argv[4], jobs) : readManifest(argv[2], jobs);
+        if (!listed) {
+            return 1;
+        }
+        return runBatch(jobs, cipherName, workers) ? 0 : 1;
+    }
+
+    // The checkpoint index stores RC4 states, so the seekable modes are RC4 only
+    if (argc > 1 && (string(argv[1]) == "--encrypt-indexed" || string(argv[1]) == "--decrypt-range") &&
+        cipherName != "rc4") {
+        cerr << argv[1] << " is only available for rc4\n";
+        return 1;
+    }
+
+    // Indexed encryption: raw binary output plus a checkpoint index in <output_file>.idx
+    if (argc > 1 && string(argv[1]) == "--encrypt-indexed") {
+        uint64_t intervalMiB = 64;
+        if ((argc != 5 && argc != 6) || (argc == 6 && !parseUnsigned<uint64_t>(argv[5], intervalMiB, UINT64_MAX >> 20))) {
+            cerr << "Usage: ./rc4 --encrypt-indexed <key_file> <input_file> <output_file> [interval_MiB]\n";
+            return 1;
+        }
+        uint64_t interval = intervalMiB << 20;
+        if (interval == 0) {
+            cerr << "The checkpoint interval must be at least 1 MiB\n";
+            return 1;
+        }
+        vector<uint8_t> key = readFile(argv[2]);
+        if (!encryptFileIndexed(argv[3], argv[4], string(argv[4]) + ".idx", key, interval)) {
+            return 1;
+        }
+        cout << "Encryption done! Ciphertext saved to " << argv[4] << ", index to " << argv[4] << ".idx." << endl;
+        return 0;
+    }
+
+    // Range decryption: uses <cipher_file>.idx when it exists
+    if (argc > 1 && string(argv[1]) == "--decrypt-range") {
+        uint64_t offset;
+        size_t length;
+        if (argc != 7 || !parseUnsigned<uint64_t>(argv[4], offset) || !parseUnsigned(argv[5], length)) {
+            cerr << "Usage: ./rc4 --decrypt-range <key_file> <cipher_file> <offset> <length> <output_file>\n";
+            return 1;
+        }
+        vector<uint8_t> key = readFile(argv[2]);
+        vector<uint8_t> plain;
+        if (!decryptRange(argv[3], string(argv[3]) + ".idx", key, offset, length, plain)) {
+            return 1;
+        }
+        writeFile(argv[6], plain);
+        cout << "Decrypted " << plain.size() << " bytes to " << argv[6] << "." << endl;
+        return 0;
+    }
+
+    // --raw writes the ciphertext as raw binary instead of hexadecimal text
+    bool raw = argc > 1 && string(argv[1]) == "--raw";
+    string cipherFilename = raw ? "cipherText.bin" : "cipherText.txt";
+
+    // 1. Read the key; the plaintext is streamed in fixed-size chunks
+    unique_ptr<StreamCipher> cipher = makeCipher(cipherName, readFile("key.txt"));
+    if (!cipher) {
+        return 1;
+    }
+
+    // 2. Encrypt the plaintext and write the ciphertext to cipherText.txt (cipherText.bin with --raw)
+    encryptFile("plainText.txt", cipherFilename, *cipher, raw);
+
+    cout << "Encryption done! Ciphertext saved to " << cipherFilename << "." << endl;
+
+    // 3. Read the key again for decryption
+    unique_ptr<StreamCipher> cipherForDecryption = makeCipher(cipherName, readFile("key.txt"));
 
     // 4. Decrypt the ciphertext and write the plaintext to decryptedPlainText.txt
-    vector<uint8_t> decryptedText = rc4EncryptDecrypt(ciphertextToDecrypt, keyForDecryption);
-    writeFile("decryptedPlainText.txt", decryptedText);
+    if (!decryptFile(cipherFilename, "decryptedPlainText.txt", *cipherForDecryption, raw)) {
+        return 1;
+    }
 
     cout << "Decryption done! Decrypted text saved to decryptedPlainText.txt." << endl;
 
@@ -0,0 +1,303 @@
+#ifndef RC4_H
+#define RC4_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include "streamcipher.h"
+
+// Function to initialize the state array and the key array
+inline void initializeStateAndKey(const std::vector<uint8_t> &key, std::vector<uint8_t> &S, std::vector<uint8_t> &K) {
+    size_t keyLength = key.size();
+
+    for (int i = 0; i < 256; i++) {
+        S[i] = i;
+        K[i] = key[i % keyLength];
+    }
+
+    int j = 0;
+    for (int i = 0; i < 256; i++) {
+        j = (j + S[i] + K[i]) % 256;
+        std::swap(S[i], S[j]);
+    }
+}
+
+// Stateful RC4 cipher: keeps S, i and j between calls so the input can be fed in chunks
+class Rc4Stream : public StreamCipher {
+public:
+    // Snapshot of (S, i, j), enough to resume the keystream exactly where it was taken
+    struct State {
+        uint8_t S[256];
+        uint8_t i, j;
+    };
+
+    explicit Rc4Stream(const std::vector<uint8_t> &key) : S(256), i(0), j(0) {
+        std::vector<uint8_t> K(256);
+        initializeStateAndKey(key, S, K);
+    }
+
+    // Resume from a snapshot taken with save(), or from a state finished by Rc4PrefixCache
+    explicit Rc4Stream(const State &state) : S(256) {
+        restore(state);
+    }
+
+    // XOR the next len keystream bytes into in and store the result in out (in and out may alias)
+    void update(const uint8_t *in, uint8_t *out, size_t len) override {
+        for (size_t n = 0; n < len; n++) {
+            i = (i + 1) % 256;
+            j = (j + S[i]) % 256;
+            std::swap(S[i], S[j]);
+            uint8_t k = S[(S[i] + S[j]) % 256];
+            out[n] = in[n] ^ k;
+        }
+    }
+
+    // Advance the keystream by len bytes without producing output
+    void discard(uint64_t len) {
+        for (uint64_t n = 0; n < len; n++) {
+            i = (i + 1) % 256;
+            j = (j + S[i]) % 256;
+            std::swap(S[i], S[j]);
+        }
+    }
+
+    State save() const {
+        State state;
+        std::copy(S.begin(), S.end(), state.S);
+        state.i = i;
+        state.j = j;
+        return state;
+    }
+
+    void restore(const State &state) {
+        std::copy(state.S, state.S + 256, S.begin());
+        i = state.i;
+        j = state.j;
+    }
+
+private:
+    std::vector<uint8_t> S;
+    int i, j;
+};
+
+// Fixed-layout RC4 state for keys of exactly KeyLen bytes. S is a std::array and the
+// indices are uint8_t, so all index arithmetic wraps for free and the whole state
+// (258 bytes) lives on the stack. With KeyLen known at compile time the KSA is fully
+// unrolled and key[x % KeyLen] becomes a constant offset. setKey() reuses the same
+// object for the next message without touching the heap.
+template <size_t KeyLen>
+class Rc4State {
+    static_assert(KeyLen >= 1 && KeyLen <= 256, "RC4 keys are 1 to 256 bytes");
+
+public:
+    Rc4State() = default;
+
+    explicit Rc4State(const uint8_t *key) {
+        setKey(key);
+    }
+
+    void setKey(const uint8_t *key) {
+        for (int x = 0; x < 256; x++) {
+            S[x] = x;
+        }
+        uint8_t k = 0;
+#pragma GCC unroll 256
+        for (int x = 0; x < 256; x++) {
+            k += S[x] + key[x % KeyLen];
+            std::swap(S[x], S[k]);
+        }
+        i = 0;
+        j = 0;
+    }
+
+    // XOR the next len keystream bytes into in and store the result in out (in and out may alias)
+    void update(const uint8_t *in, uint8_t *out, size_t len) {
+        uint8_t li = i, lj = j;
+        for (size_t n = 0; n < len; n++) {
+            li++;
+            uint8_t si = S[li];
+            lj += si;
+            uint8_t sj = S[lj];
+            S[li] = sj;
+            S[lj] = si;
+            out[n] = in[n] ^ S[(uint8_t)(si + sj)];
+        }
+        i = li;
+        j = lj;
+    }
+
+private:
+    std::array<uint8_t, 256> S;
+    uint8_t i = 0, j = 0;
+};
+
+// KSA state for keys of the form prefix || nonce. Iterations 0..len(prefix)-1 of the KSA
+// only read prefix bytes, so their permutation and j are computed once per prefix and
+// each nonce only pays for the remaining 256 - len(prefix) iterations.
+class Rc4PrefixCache {
+public:
+    // The prefix must not be empty: there would be nothing to cache, and prefix || nonce
+    // with an empty nonce would be an empty key
+    explicit Rc4PrefixCache(const std::vector<uint8_t> &prefix) : prefix(prefix), j(0) {
+        if (prefix.empty()) {
+            throw std::invalid_argument("Rc4PrefixCache needs a non-empty key prefix");
+        }
+        done = prefix.size() < 256 ? prefix.size() : 256;
+        for (int x = 0; x < 256; x++) {
+            S[x] = x;
+        }
+        for (size_t x = 0; x < done; x++) {
+            j = j + S[x] + prefix[x];
+            std::swap(S[x], S[j]);
+        }
+    }
+
+    // Function to finish the KSA for key = prefix || nonce and return the ready cipher
+    Rc4Stream withNonce(const uint8_t *nonce, size_t nonceLen) const {
+        Rc4Stream::State state;
+        std::copy(S, S + 256, state.S);
+        size_t keyLength = prefix.size() + nonceLen;
+        uint8_t k = j;
+        for (size_t x = done; x < 256; x++) {
+            size_t pos = x % keyLength;
+            k = k + state.S[x] + (pos < prefix.size() ? prefix[pos] : nonce[pos - prefix.size()]);
+            std::swap(state.S[x], state.S[k]);
+        }
+        state.i = 0;
+        state.j = 0;
+        return Rc4Stream(state);
+    }
+
+private:
+    std::vector<uint8_t> prefix;
+    size_t done;
+    uint8_t S[256];
+    uint8_t j;
+};
+
+// Function to encrypt or decrypt the input data using RC4
+inline std::vector<uint8_t> rc4EncryptDecrypt(const std::vector<uint8_t> &input, const std::vector<uint8_t> &key) {
+    Rc4Stream rc4(key);
+    std::vector<uint8_t> output(input.size());
+    rc4.update(input.data(), output.data(), input.size());
+    return output;
+}
+
+// Lanes independent RC4 states advanced in lockstep. The S-boxes are interleaved
+// (entry x of lane l lives at S[x * Lanes + l]) so the lanes' loads share cache lines
+// and the out-of-order core can overlap the otherwise serial i/j/swap chains.
+template <size_t Lanes>
+class Rc4MultiLane {
+public:
+    // keys points at Lanes keys, one per lane; the KSA runs interleaved across all lanes
+    explicit Rc4MultiLane(const std::vector<uint8_t> *keys) : S(256 * Lanes), i(0) {
+        for (int x = 0; x < 256; x++) {
+            for (size_t l = 0; l < Lanes; l++) {
+                S[x * Lanes + l] = x;
+            }
+        }
+        for (size_t l = 0; l < Lanes; l++) {
+            j[l] = 0;
+            pos[l] = 0;
+        }
+
+        for (int x = 0; x < 256; x++) {
+            for (size_t l = 0; l < Lanes; l++) {
+                const std::vector<uint8_t> &key = keys[l];
+                j[l] = j[l] + S[x * Lanes + l] + key[x % key.size()];
+                std::swap(S[x * Lanes + l], S[j[l] * Lanes + l]);
+            }
+        }
+        // The PRGA starts again from j = 0
+        for (size_t l = 0; l < Lanes; l++) {
+            j[l] = 0;
+        }
+    }
+
+    // Advance every lane by len bytes; in[l]/out[l] are the buffers of lane l (they may alias).
+    // All lanes must be at the same stream position, i.e. only updateLane() calls break lockstep.
+    void update(const uint8_t *const in[Lanes], uint8_t *const out[Lanes], size_t len) {
+        uint8_t *s = S.data();
+        for (size_t n = 0; n < len; n++) {
+            i++;
+            for (size_t l = 0; l < Lanes; l++) {
+                uint8_t si = s[i * Lanes + l];
+                j[l] += si;
+                uint8_t sj = s[j[l] * Lanes + l];
+                s[i * Lanes + l] = sj;
+                s[j[l] * Lanes + l] = si;
+                out[l][n] = in[l][n] ^ s[(uint8_t)(si + sj) * Lanes + l];
+            }
+        }
+        for (size_t l = 0; l < Lanes; l++) {
+            pos[l] = i;
+        }
+    }
+
+    // Advance a single lane by len bytes, used for the tails of unequal-length streams
+    void updateLane(size_t l, const uint8_t *in, uint8_t *out, size_t len) {
+        uint8_t *s = S.data();
+        uint8_t li = pos[l];
+        uint8_t lj = j[l];
+        for (size_t n = 0; n < len; n++) {
+            li++;
+            uint8_t si = s[li * Lanes + l];
+            lj += si;
+            uint8_t sj = s[lj * Lanes + l];
+            s[li * Lanes + l] = sj;
+            s[lj * Lanes + l] = si;
+            out[n] = in[n] ^ s[(uint8_t)(si + sj) * Lanes + l];
+        }
+        pos[l] = li;
+        j[l] = lj;
+    }
+
+private:
+    std::vector<uint8_t> S;
+    uint8_t i;
+    uint8_t j[Lanes];
+    uint8_t pos[Lanes];
+};
+
+// Function to encrypt or decrypt many independent streams, each with its own key,
+// Lanes streams at a time. Lanes run in lockstep for their common length and the
+// remaining tail of each stream is finished lane by lane.
+template <size_t Lanes>
+std::vector<std::vector<uint8_t>> rc4EncryptDecryptBatch(const std::vector<std::vector<uint8_t>> &inputs,
+                                                         const std::vector<std::vector<uint8_t>> &keys) {
+    std::vector<std::vector<uint8_t>> outputs(inputs.size());
+    for (size_t s = 0; s < inputs.size(); s++) {
+        outputs[s].resize(inputs[s].size());
+    }
+
+    size_t fullGroups = inputs.size() / Lanes * Lanes;
+    for (size_t base = 0; base < fullGroups; base += Lanes) {
+        Rc4MultiLane<Lanes> rc4(&keys[base]);
+        const uint8_t *in[Lanes];
+        uint8_t *out[Lanes];
+        size_t common = inputs[base].size();
+        for (size_t l = 0; l < Lanes; l++) {
+            in[l] = inputs[base + l].data();
+            out[l] = outputs[base + l].data();
+            if (inputs[base + l].size() < common) common = inputs[base + l].size();
+        }
+
+        rc4.update(in, out, common);
+        for (size_t l = 0; l < Lanes; l++) {
+            rc4.updateLane(l, in[l] + common, out[l] + common, inputs[base + l].size() - common);
+        }
+    }
+
+    // Leftover streams that do not fill a whole group use the single-stream cipher
+    for (size_t s = fullGroups; s < inputs.size(); s++) {
+        Rc4Stream rc4(keys[s]);
+        rc4.update(inputs[s].data(), outputs[s].data(), inputs[s].size());
+    }
+    return outputs;
+}
+
+#endif
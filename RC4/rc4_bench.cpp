@@ -0,0 +1,376 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include "rc4.h"
+#include "hexcodec.h"
+#include "chacha20.h"
+#include "argparse.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+// Function to read a cycle counter (TSC on x86, nanoseconds elsewhere)
+uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// One measurement, kept so the whole run can also be written out as JSON
+struct BenchResult {
+    string group, name;
+    double value;
+    string unit;
+};
+
+vector<BenchResult> results;
+
+// Timed loops fold their output in here so the compiler cannot drop them
+volatile uint8_t sink;
+
+void record(const string &group, const string &name, double value, const string &unit) {
+    results.push_back({group, name, value, unit});
+}
+
+// Function to write every recorded measurement as a JSON array
+bool writeJson(const string &filename) {
+    ofstream file(filename);
+    file << "[\n";
+    for (size_t r = 0; r < results.size(); r++) {
+        const BenchResult &res = results[r];
+        file << "  {\"group\": \"" << res.group << "\", \"name\": \"" << res.name << "\", \"value\": "
+             << setprecision(6) << res.value << ", \"unit\": \"" << res.unit << "\"}"
+             << (r + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "]\n";
+    return static_cast<bool>(file);
+}
+
+// Function to format a byte count as 64B / 16KiB / 1GiB
+string sizeLabel(uint64_t bytes) {
+    if (bytes >= (1ULL << 30) && bytes % (1ULL << 30) == 0) return to_string(bytes >> 30) + "GiB";
+    if (bytes >= (1ULL << 20) && bytes % (1ULL << 20) == 0) return to_string(bytes >> 20) + "MiB";
+    if (bytes >= (1ULL << 10) && bytes % (1ULL << 10) == 0) return to_string(bytes >> 10) + "KiB";
+    return to_string(bytes) + "B";
+}
+
+// Function to encrypt every stream with its own single-stream RC4 state
+vector<vector<uint8_t>> encryptSerial(const vector<vector<uint8_t>> &inputs, const vector<vector<uint8_t>> &keys) {
+    vector<vector<uint8_t>> outputs(inputs.size());
+    for (size_t s = 0; s < inputs.size(); s++) {
+        outputs[s] = rc4EncryptDecrypt(inputs[s], keys[s]);
+    }
+    return outputs;
+}
+
+// Function to time one batch encryption and print aggregate bytes/cycle
+template <typename F>
+void report(const string &group, const string &name, size_t totalBytes, const vector<vector<uint8_t>> &expected, F run) {
+    const int reps = 5;
+    uint64_t best = ~0ULL;
+    vector<vector<uint8_t>> outputs;
+    for (int r = 0; r < reps; r++) {
+        uint64_t start = readCycles();
+        outputs = run();
+        uint64_t elapsed = readCycles() - start;
+        if (elapsed < best) best = elapsed;
+    }
+
+    cout << "  " << setw(10) << left << name << right
+         << setw(12) << fixed << setprecision(4) << (double)totalBytes / best << " bytes/cycle"
+         << (outputs == expected ? "" : "  MISMATCH") << endl;
+    record(group, name, (double)totalBytes / best, "bytes/cycle");
+}
+
+// Function to compare the single-stream loop with the multi-lane engine
+void benchMultiLane(size_t streams) {
+    mt19937_64 rng(42);
+
+    vector<vector<uint8_t>> keys(streams, vector<uint8_t>(16));
+    for (auto &key : keys) {
+        for (auto &b : key) b = rng();
+    }
+
+    cout << "Multi-lane RC4: " << streams << " independent streams, key setup included" << endl;
+    for (size_t length : {64, 256, 1500, 16384}) {
+        vector<vector<uint8_t>> inputs(streams, vector<uint8_t>(length));
+        for (auto &in : inputs) {
+            for (auto &b : in) b = rng();
+        }
+        size_t totalBytes = streams * length;
+        vector<vector<uint8_t>> expected = encryptSerial(inputs, keys);
+
+        string group = "multilane/" + sizeLabel(length);
+        cout << length << "-byte streams:" << endl;
+        report(group, "serial", totalBytes, expected, [&] { return encryptSerial(inputs, keys); });
+        report(group, "4 lanes", totalBytes, expected, [&] { return rc4EncryptDecryptBatch<4>(inputs, keys); });
+        report(group, "8 lanes", totalBytes, expected, [&] { return rc4EncryptDecryptBatch<8>(inputs, keys); });
+        report(group, "16 lanes", totalBytes, expected, [&] { return rc4EncryptDecryptBatch<16>(inputs, keys); });
+    }
+}
+
+// Function to measure packets/sec for short messages keyed as prefix || nonce,
+// running the full KSA per packet versus finishing it from a cached prefix state
+void benchPrefixCache(size_t packets) {
+    mt19937_64 rng(7);
+    const size_t nonceLength = 16;
+
+    cout << "KSA prefix cache: " << packets << " packets, " << nonceLength << "-byte nonce" << endl;
+    for (size_t prefixLength : {16, 64, 128, 240}) {
+        vector<uint8_t> prefix(prefixLength);
+        for (auto &b : prefix) b = rng();
+        vector<uint8_t> nonces(packets * nonceLength);
+        for (auto &b : nonces) b = rng();
+        Rc4PrefixCache cache(prefix);
+
+        for (size_t messageLength : {16, 32, 64}) {
+            vector<uint8_t> message(messageLength), out(messageLength);
+            for (auto &b : message) b = rng();
+            uint8_t check[2] = {0, 0};
+
+            auto start = chrono::steady_clock::now();
+            vector<uint8_t> key(prefix);
+            key.resize(prefixLength + nonceLength);
+            for (size_t p = 0; p < packets; p++) {
+                copy(&nonces[p * nonceLength], &nonces[(p + 1) * nonceLength], key.begin() + prefixLength);
+                Rc4Stream rc4(key);
+                rc4.update(message.data(), out.data(), messageLength);
+                check[0] ^= out[0];
+            }
+            double full = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            start = chrono::steady_clock::now();
+            for (size_t p = 0; p < packets; p++) {
+                Rc4Stream rc4 = cache.withNonce(&nonces[p * nonceLength], nonceLength);
+                rc4.update(message.data(), out.data(), messageLength);
+                check[1] ^= out[0];
+            }
+            double cached = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            cout << "  prefix " << setw(3) << prefixLength << " B, message " << setw(2) << messageLength << " B: "
+                 << fixed << setprecision(0) << setw(10) << packets / full << " packets/s full KSA, "
+                 << setw(10) << packets / cached << " packets/s cached prefix"
+                 << (check[0] == check[1] ? "" : "  MISMATCH") << endl;
+            string name = "prefix " + to_string(prefixLength) + "B, message " + to_string(messageLength) + "B";
+            record("prefix-cache/full", name, packets / full, "packets/s");
+            record("prefix-cache/cached", name, packets / cached, "packets/s");
+        }
+    }
+}
+
+// Function to time key setup plus encryption of one message, repeated over many messages
+template <typename F>
+double nsPerMessage(size_t messages, F run) {
+    auto start = chrono::steady_clock::now();
+    for (size_t m = 0; m < messages; m++) {
+        run(m);
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / messages;
+}
+
+// Function to compare the vector-based functions with the compile-time specialized Rc4State
+template <size_t KeyLen>
+void benchFixedState(size_t messages) {
+    mt19937_64 rng(KeyLen);
+    vector<uint8_t> keys(messages * KeyLen);
+    for (auto &b : keys) b = rng();
+
+    for (size_t messageLength : {64, 1024}) {
+        vector<uint8_t> message(messageLength), out(messageLength);
+        for (auto &b : message) b = rng();
+        uint8_t check[2] = {0, 0};
+
+        double generic = nsPerMessage(messages, [&](size_t m) {
+            vector<uint8_t> key(&keys[m * KeyLen], &keys[(m + 1) * KeyLen]);
+            vector<uint8_t> cipher = rc4EncryptDecrypt(message, key);
+            check[0] ^= cipher[messageLength - 1];
+        });
+
+        Rc4State<KeyLen> state;
+        double fixedLayout = nsPerMessage(messages, [&](size_t m) {
+            state.setKey(&keys[m * KeyLen]);
+            state.update(message.data(), out.data(), messageLength);
+            check[1] ^= out[messageLength - 1];
+        });
+
+        cout << "  key " << setw(2) << KeyLen << " B, message " << setw(4) << messageLength << " B: "
+             << fixed << setprecision(0) << setw(7) << generic << " ns rc4EncryptDecrypt, "
+             << setw(7) << fixedLayout << " ns Rc4State<" << KeyLen << ">"
+             << (check[0] == check[1] ? "" : "  MISMATCH") << endl;
+        string name = "key " + to_string(KeyLen) + "B, message " + to_string(messageLength) + "B";
+        record("fixed-state/rc4EncryptDecrypt", name, generic, "ns/message");
+        record("fixed-state/Rc4State", name, fixedLayout, "ns/message");
+    }
+}
+
+// Function to measure PRGA cycles/byte for input sizes from 64 B up to maxSize. The state is
+// keyed outside the timed region; sizes above 1 MiB stream through a reused 1 MiB buffer.
+// Also measures the whole rc4EncryptDecrypt call (key setup, allocation, PRGA) per size.
+void benchPrga(uint64_t maxSize) {
+    mt19937_64 rng(1);
+    vector<uint8_t> key(16);
+    for (auto &b : key) b = rng();
+    vector<uint8_t> buffer(1 << 20);
+    for (auto &b : buffer) b = rng();
+
+    cout << "PRGA cycles/byte:" << endl;
+    for (uint64_t size = 64; size <= maxSize; size *= 4) {
+        // Repeat small sizes so every measurement covers at least 16 MiB of keystream
+        uint64_t reps = max<uint64_t>(1, (16ULL << 20) / size);
+        size_t piece = min<uint64_t>(size, buffer.size());
+
+        Rc4Stream rc4(key);
+        uint64_t start = readCycles();
+        for (uint64_t r = 0; r < reps; r++) {
+            for (uint64_t done = 0; done < size; done += piece) {
+                rc4.update(buffer.data(), buffer.data(), min<uint64_t>(piece, size - done));
+            }
+        }
+        double prga = (double)(readCycles() - start) / (reps * size);
+        sink = sink ^ buffer[0];
+
+        cout << "  " << setw(8) << sizeLabel(size) << fixed << setprecision(2) << setw(8) << prga << " PRGA";
+        record("prga", sizeLabel(size), prga, "cycles/byte");
+
+        if (size <= buffer.size()) {
+            vector<uint8_t> input(buffer.begin(), buffer.begin() + size);
+            start = readCycles();
+            for (uint64_t r = 0; r < reps; r++) {
+                sink = sink ^ rc4EncryptDecrypt(input, key)[0];
+            }
+            double whole = (double)(readCycles() - start) / (reps * size);
+            cout << setw(10) << whole << " rc4EncryptDecrypt";
+            record("rc4EncryptDecrypt", sizeLabel(size), whole, "cycles/byte");
+        }
+        cout << endl;
+    }
+}
+
+// Function to measure initializeStateAndKey (via Rc4Stream) key setups/sec across key lengths
+void benchKeySetup() {
+    mt19937_64 rng(2);
+    const size_t setups = 200000;
+    cout << "Key setups/sec:" << endl;
+    for (size_t keyLength : {1, 5, 16, 32, 64, 128, 256}) {
+        vector<uint8_t> key(keyLength);
+        for (auto &b : key) b = rng();
+        auto start = chrono::steady_clock::now();
+        for (size_t s = 0; s < setups; s++) {
+            key[0] = s;
+            Rc4Stream rc4(key);
+            uint8_t first = 0;
+            rc4.update(&first, &first, 1);
+            sink = sink ^ first;
+        }
+        double rate = setups / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "  key " << setw(3) << keyLength << " B: " << fixed << setprecision(0) << setw(10) << rate
+             << " setups/s" << endl;
+        record("key-setup", "key " + to_string(keyLength) + "B", rate, "setups/s");
+    }
+}
+
+// Function to time the hex codec behind the cipherText.txt format on its own, per kernel
+void benchHexCodec() {
+    mt19937_64 rng(3);
+    const size_t size = 64 << 20;
+    vector<uint8_t> data(size), decoded(size + 1);
+    for (auto &b : data) b = rng();
+    string text(3 * size, ' ');
+
+    cout << "Hex codec MB/s (binary side):" << endl;
+    struct Kernel {
+        HexKernel kernel;
+        const char *name;
+    };
+    for (Kernel k : {Kernel{HexKernel::Scalar, "scalar"}, Kernel{HexKernel::Ssse3, "ssse3"}, Kernel{HexKernel::Avx2, "avx2"}}) {
+        if (k.kernel > hexBestKernel()) continue;
+        auto start = chrono::steady_clock::now();
+        hexEncode(data.data(), size, &text[0], k.kernel);
+        double encode = size / 1e6 / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        start = chrono::steady_clock::now();
+        bool valid;
+        size_t got = hexDecode(text.data(), text.size(), decoded.data(), &valid, k.kernel);
+        double decode = size / 1e6 / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        bool same = valid && got == size && equal(data.begin(), data.end(), decoded.begin());
+
+        cout << "  " << setw(7) << left << k.name << right << fixed << setprecision(0) << setw(8) << encode
+             << " encode " << setw(8) << decode << " decode" << (same ? "" : "  MISMATCH") << endl;
+        record("hex-encode", k.name, encode, "MB/s");
+        record("hex-decode", k.name, decode, "MB/s");
+    }
+}
+
+// Function to compare RC4 with each ChaCha20 kernel through the common StreamCipher interface
+void benchStreamCiphers() {
+    const size_t size = 64 << 20;
+    vector<uint8_t> buffer(size, 0);
+    uint8_t key[32] = {1}, nonce[12] = {};
+
+    cout << "Stream ciphers MB/s (64 MiB through StreamCipher::update):" << endl;
+    struct Cipher {
+        const char *name;
+        StreamCipher *cipher;
+    };
+    Rc4Stream rc4(vector<uint8_t>(key, key + 16));
+    ChaCha20Stream scalar(key, nonce, 0, ChaChaKernel::Scalar);
+    ChaCha20Stream avx2(key, nonce, 0, ChaChaKernel::Avx2);
+    ChaCha20Stream avx512(key, nonce, 0, ChaChaKernel::Avx512);
+    vector<Cipher> ciphers = {{"rc4", &rc4}, {"chacha20-scalar", &scalar}};
+    if (chachaBestKernel() >= ChaChaKernel::Avx2) ciphers.push_back({"chacha20-avx2", &avx2});
+    if (chachaBestKernel() >= ChaChaKernel::Avx512) ciphers.push_back({"chacha20-avx512", &avx512});
+    for (const Cipher &c : ciphers) {
+        auto start = chrono::steady_clock::now();
+        c.cipher->update(buffer.data(), buffer.data(), size);
+        double rate = size / 1e6 / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        sink = sink + buffer[size - 1];
+        cout << "  " << setw(16) << left << c.name << right << fixed << setprecision(0) << setw(8) << rate << endl;
+        record("stream-cipher", c.name, rate, "MB/s");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t streams = 4096;
+    uint64_t maxSize = 1ULL << 30;
+    string jsonFile;
+    for (int a = 1; a < argc; a++) {
+        string arg = argv[a];
+        if (arg == "--json" && a + 1 < argc) {
+            jsonFile = argv[++a];
+        } else if (arg == "--max-size" && a + 1 < argc && parseUnsigned<uint64_t>(argv[a + 1], maxSize)) {
+            a++;
+        } else if (!parseUnsigned(arg, streams, SIZE_MAX / 64) || streams == 0) {
+            cerr << "Usage: ./rc4_bench [--json <file>] [--max-size <bytes>] [streams]\n";
+            return 1;
+        }
+    }
+
+    benchPrga(maxSize);
+    benchKeySetup();
+    benchHexCodec();
+    benchStreamCiphers();
+    benchMultiLane(streams);
+    benchPrefixCache(streams * 64);
+
+    cout << "Fixed-layout state: key setup + message, " << streams * 64 << " messages" << endl;
+    benchFixedState<5>(streams * 64);
+    benchFixedState<16>(streams * 64);
+    benchFixedState<32>(streams * 64);
+
+    if (!jsonFile.empty()) {
+        if (!writeJson(jsonFile)) {
+            cerr << "Cannot write " << jsonFile << endl;
+            return 1;
+        }
+        cout << "Results written to " << jsonFile << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include <iostream>
+#include <vector>
+#include <fstream>
+#include <string>
+#include <iomanip>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include "rc4.h"
+#include "argparse.h"
+
+using namespace std;
+
+// Keystream statistics over many random keys. Each thread generates keystreams with
+// the 16-lane engine and counts, in its own histograms:
+//  - per-position: how often byte value v appears at keystream position r (1-based),
+//    for r = 1..positions (e.g. the second-byte bias Pr[z2 = 0] = 2/256);
+//  - digraphs: how often the pair (z_r, z_r+1) appears for the digraphBytes bytes
+//    that follow the per-position window (long-term digraph biases).
+// Counters are 32-bit rows laid out [position][value] and flushed into 64-bit
+// per-thread totals before they can overflow; the totals are merged at the end.
+
+const size_t LANES = 16;
+const size_t KEY_LENGTH = 16;
+const uint64_t FLUSH_KEYS = 1 << 16;
+
+struct Histograms {
+    vector<uint64_t> positions;  // positions x 256
+    vector<uint64_t> digraphs;   // 65536
+};
+
+// Function to add 32-bit counters into 64-bit totals and clear them
+void flush(vector<uint32_t> &counts, vector<uint64_t> &totals) {
+    for (size_t n = 0; n < counts.size(); n++) {
+        totals[n] += counts[n];
+    }
+    fill(counts.begin(), counts.end(), 0);
+}
+
+// Function run by each analysis thread on its share of the keys
+void analyzeKeys(uint64_t keys, size_t positions, size_t digraphBytes, uint64_t seed, Histograms &result) {
+    mt19937_64 rng(seed);
+    size_t length = positions + digraphBytes;
+    vector<uint32_t> positionCounts(positions * 256), digraphCounts(65536);
+    result.positions.assign(positions * 256, 0);
+    result.digraphs.assign(65536, 0);
+
+    vector<vector<uint8_t>> laneKeys(LANES, vector<uint8_t>(KEY_LENGTH));
+    vector<uint8_t> zeros(length, 0);
+    vector<vector<uint8_t>> keystreams(LANES, vector<uint8_t>(length));
+    const uint8_t *in[LANES];
+    uint8_t *out[LANES];
+    for (size_t l = 0; l < LANES; l++) {
+        in[l] = zeros.data();
+        out[l] = keystreams[l].data();
+    }
+
+    uint64_t sinceFlush = 0;
+    for (uint64_t done = 0; done < keys; done += LANES) {
+        size_t lanes = min<uint64_t>(LANES, keys - done);
+        for (auto &key : laneKeys) {
+            for (size_t b = 0; b < KEY_LENGTH; b += 8) {
+                uint64_t r = rng();
+                copy(reinterpret_cast<uint8_t *>(&r), reinterpret_cast<uint8_t *>(&r) + 8, key.begin() + b);
+            }
+        }
+        Rc4MultiLane<LANES> rc4(laneKeys.data());
+        rc4.update(in, out, length);
+
+        for (size_t l = 0; l < lanes; l++) {
+            const uint8_t *z = keystreams[l].data();
+            uint32_t *row = positionCounts.data();
+            for (size_t r = 0; r < positions; r++, row += 256) {
+                row[z[r]]++;
+            }
+            for (size_t r = positions; r + 1 < length; r++) {
+                digraphCounts[(z[r] << 8) | z[r + 1]]++;
+            }
+        }
+
+        // A digraph bin can take at most FLUSH_KEYS * digraphBytes hits between flushes
+        sinceFlush += lanes;
+        if (sinceFlush >= FLUSH_KEYS || digraphBytes * (sinceFlush + LANES) >= (1ULL << 31)) {
+            flush(positionCounts, result.positions);
+            flush(digraphCounts, result.digraphs);
+            sinceFlush = 0;
+        }
+    }
+    flush(positionCounts, result.positions);
+    flush(digraphCounts, result.digraphs);
+}
+
+struct Bias {
+    size_t where;
+    double ratio, z;
+};
+
+// Function to rank histogram bins by how far they are from the uniform expectation
+vector<Bias> topBiases(const vector<uint64_t> &counts, size_t bins, double trialsPerRow, size_t top) {
+    double p = 1.0 / bins;
+    double expected = trialsPerRow * p;
+    double sigma = sqrt(trialsPerRow * p * (1 - p));
+    vector<Bias> biases;
+    for (size_t n = 0; n < counts.size(); n++) {
+        biases.push_back({n, counts[n] / expected, (counts[n] - expected) / sigma});
+    }
+    size_t keep = min(top, biases.size());
+    partial_sort(biases.begin(), biases.begin() + keep, biases.end(),
+                 [](const Bias &a, const Bias &b) { return fabs(a.z) > fabs(b.z); });
+    biases.resize(keep);
+    return biases;
+}
+
+// Function to write a histogram as CSV rows "row,value,count"
+void writeCsv(const string &filename, const vector<uint64_t> &counts, size_t bins, int rowBase) {
+    ofstream file(filename);
+    file << "row,value,count\n";
+    for (size_t n = 0; n < counts.size(); n++) {
+        file << n / bins + rowBase << "," << n % bins << "," << counts[n] << "\n";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    vector<string> args(argv + 1, argv + argc);
+    string csvPrefix;
+    auto csv = find(args.begin(), args.end(), "--csv");
+    if (csv != args.end() && csv + 1 != args.end()) {
+        csvPrefix = *(csv + 1);
+        args.erase(csv, csv + 2);
+    }
+    uint64_t keys = 0;
+    size_t positions = 256, digraphBytes = 1024, threads = max(1u, thread::hardware_concurrency());
+    if (args.empty() || args.size() > 4 || !parseUnsigned<uint64_t>(args[0], keys) ||
+        (args.size() > 1 && !parseUnsigned(args[1], positions)) ||
+        (args.size() > 2 && !parseUnsigned(args[2], digraphBytes)) ||
+        (args.size() > 3 && !parseUnsigned(args[3], threads))) {
+        cerr << "Usage: ./rc4_bias <keys> [positions] [digraph_bytes] [threads] [--csv <prefix>]\n";
+        return 1;
+    }
+    if (keys == 0 || threads == 0 || positions + digraphBytes == 0) {
+        cerr << "Need at least one key, one thread and one keystream byte\n";
+        return 1;
+    }
+
+    cout << "Analyzing " << keys << " random " << KEY_LENGTH << "-byte keys on " << threads << " threads: "
+         << positions << " positions, " << digraphBytes << " digraph bytes per key" << endl;
+
+    random_device seeder;
+    vector<Histograms> partial(threads);
+    vector<thread> pool;
+    auto start = chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; t++) {
+        uint64_t share = keys / threads + (t < keys % threads);
+        uint64_t seed = ((uint64_t)seeder() << 32) ^ seeder();
+        pool.emplace_back(analyzeKeys, share, positions, digraphBytes, seed, ref(partial[t]));
+    }
+    for (thread &t : pool) {
+        t.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Merge the per-thread histograms
+    Histograms total = partial[0];
+    for (size_t t = 1; t < threads; t++) {
+        for (size_t n = 0; n < total.positions.size(); n++) total.positions[n] += partial[t].positions[n];
+        for (size_t n = 0; n < total.digraphs.size(); n++) total.digraphs[n] += partial[t].digraphs[n];
+    }
+
+    double bytes = (double)keys * (positions + digraphBytes);
+    cout << fixed << setprecision(2) << bytes / 1e9 << " GB of keystream in " << seconds << " s ("
+         << bytes / 1e9 / seconds << " GB/s)" << endl;
+
+    if (positions >= 2) {
+        double pz2 = (double)total.positions[256 + 0] / keys;
+        cout << setprecision(5) << "Pr[z2 = 0] = " << pz2 << " (" << setprecision(3) << pz2 * 256
+             << " x uniform; expected about 2 x)" << endl;
+    }
+    if (positions > 0) {
+        cout << "Most biased (position, value):" << endl;
+        for (const Bias &b : topBiases(total.positions, 256, (double)keys, 10)) {
+            cout << "  z" << b.where / 256 + 1 << " = " << setw(3) << b.where % 256 << ": " << setprecision(4)
+                 << b.ratio << " x uniform, z = " << setprecision(1) << b.z << endl;
+        }
+    }
+    if (digraphBytes > 1) {
+        cout << "Most biased digraphs (z_r, z_r+1) after position " << positions << ":" << endl;
+        for (const Bias &b : topBiases(total.digraphs, 65536, (double)keys * (digraphBytes - 1), 10)) {
+            cout << "  (" << setw(3) << b.where / 256 << ", " << setw(3) << b.where % 256 << "): " << setprecision(4)
+                 << b.ratio << " x uniform, z = " << setprecision(1) << b.z << endl;
+        }
+    }
+
+    if (!csvPrefix.empty()) {
+        writeCsv(csvPrefix + "_positions.csv", total.positions, 256, 1);
+        writeCsv(csvPrefix + "_digraphs.csv", total.digraphs, 256, 0);
+        cout << "Histograms written to " << csvPrefix << "_positions.csv and " << csvPrefix << "_digraphs.csv" << endl;
+    }
+    return 0;
+}
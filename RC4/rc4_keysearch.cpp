@@ -0,0 +1,218 @@
+#include <iostream>
+#include <vector>
+#include <fstream>
+#include <string>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include "rc4.h"
+#include "hexcodec.h"
+#include "argparse.h"
+
+using namespace std;
+
+// Brute-force search for a short RC4 key (e.g. 40-bit export-grade) from a known
+// plaintext/ciphertext pair. Keys are enumerated as big-endian counters over
+// keyBytes bytes. Each thread runs the KSA for LANES keys at once over an
+// interleaved S-box layout and only checks a key fully when its first keystream
+// byte matches.
+
+const size_t LANES = 16;
+const uint64_t CHUNK_KEYS = 1 << 20;
+
+// Function to read the content of a file into a vector
+vector<uint8_t> readFile(const string &filename) {
+    ifstream file(filename, ios::binary);
+    return vector<uint8_t>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+// Function to turn a key counter into its big-endian key bytes
+template <size_t KeyLen>
+void counterToKey(uint64_t counter, uint8_t *key) {
+    for (size_t b = KeyLen; b-- > 0;) {
+        key[b] = counter & 0xFF;
+        counter >>= 8;
+    }
+}
+
+struct SearchState {
+    vector<uint8_t> plaintext, ciphertext;
+    uint8_t firstKeystreamByte;
+    uint64_t lastKey;  // highest key counter, inclusive: 2^(8 * keyBytes) - 1
+    atomic<uint64_t> nextChunk{0};
+    atomic<uint64_t> keysTried{0};
+    atomic<bool> found{false};
+    mutex resultLock;
+    vector<uint8_t> key;
+};
+
+// Function to check a candidate key against the whole known plaintext
+bool verifyKey(const SearchState &search, const vector<uint8_t> &key) {
+    vector<uint8_t> decrypted = rc4EncryptDecrypt(search.ciphertext, key);
+    return decrypted == search.plaintext;
+}
+
+// Function run by every search thread: takes chunks of the keyspace until it is exhausted or a key is found
+template <size_t KeyLen>
+void searchWorker(SearchState &search) {
+    alignas(64) uint8_t S[256 * LANES];
+    uint8_t keys[LANES][KeyLen];
+
+    for (;;) {
+        // Chunk bounds are inclusive so an 8-byte search reaches key 2^64 - 1 without overflowing
+        uint64_t chunk = search.nextChunk++;
+        if (chunk > search.lastKey / CHUNK_KEYS || search.found) return;
+        uint64_t first = chunk * CHUNK_KEYS;
+        uint64_t last = search.lastKey - first < CHUNK_KEYS ? search.lastKey : first + (CHUNK_KEYS - 1);
+
+        for (uint64_t base = first;; base += LANES) {
+            size_t lanes = min<uint64_t>(LANES, last - base + 1);
+            for (size_t l = 0; l < LANES; l++) {
+                // Spare lanes of the final group repeat the last key; their results are ignored
+                counterToKey<KeyLen>(base + min(l, lanes - 1), keys[l]);
+            }
+
+            // Interleaved KSA: entry x of lane l lives at S[x * LANES + l]
+            for (int x = 0; x < 256; x++) {
+                for (size_t l = 0; l < LANES; l++) {
+                    S[x * LANES + l] = x;
+                }
+            }
+            uint8_t j[LANES] = {};
+#pragma GCC unroll 256
+            for (int x = 0; x < 256; x++) {
+                for (size_t l = 0; l < LANES; l++) {
+                    j[l] += S[x * LANES + l] + keys[l][x % KeyLen];
+                    swap(S[x * LANES + l], S[j[l] * LANES + l]);
+                }
+            }
+
+            // First PRGA step: i = 1, j = S[1], then S[1] and S[j] are swapped. The swap is
+            // applied virtually when the output index t lands on one of the two entries.
+            for (size_t l = 0; l < lanes; l++) {
+                uint8_t si = S[1 * LANES + l];
+                uint8_t sj = S[si * LANES + l];
+                uint8_t t = si + sj;
+                uint8_t k = t == 1 ? sj : t == si ? si : S[t * LANES + l];
+                if (k != search.firstKeystreamByte) continue;
+
+                vector<uint8_t> candidate(keys[l], keys[l] + KeyLen);
+                if (verifyKey(search, candidate)) {
+                    lock_guard<mutex> lock(search.resultLock);
+                    if (!search.found) {
+                        search.key = candidate;
+                        search.found = true;
+                    }
+                }
+            }
+            if (search.found) return;
+            if (last - base < LANES) break;
+        }
+        search.keysTried += last - first + 1;
+    }
+}
+
+// Function to start the search threads for a compile-time key length and report progress until they finish
+template <size_t KeyLen>
+void runSearch(SearchState &search, size_t threads) {
+    vector<thread> pool;
+    for (size_t t = 0; t < threads; t++) {
+        pool.emplace_back(searchWorker<KeyLen>, ref(search));
+    }
+
+    atomic<bool> done(false);
+    thread progress([&] {
+        auto start = chrono::steady_clock::now();
+        while (!done) {
+            for (int tick = 0; tick < 50 && !done; tick++) {
+                this_thread::sleep_for(chrono::milliseconds(100));
+            }
+            if (done) break;
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            uint64_t tried = search.keysTried;
+            double rate = tried / seconds;
+            double keyspace = search.lastKey + 1.0;
+            cerr << fixed << setprecision(2) << "  " << 100.0 * tried / keyspace << "% searched, "
+                 << setprecision(0) << rate << " keys/s, ETA " << (rate > 0 ? (keyspace - tried) / rate : 0)
+                 << " s" << endl;
+        }
+    });
+
+    for (thread &t : pool) {
+        t.join();
+    }
+    done = true;
+    progress.join();
+}
+
+int main(int argc, char *argv[]) {
+    bool hexInput = argc > 1 && string(argv[1]) == "--hex";
+    int first = hexInput ? 2 : 1;
+    size_t keyBytes = 0, threads = max(1u, thread::hardware_concurrency());
+    if ((argc - first != 3 && argc - first != 4) || !parseUnsigned(argv[first + 2], keyBytes) ||
+        (argc - first == 4 && !parseUnsigned(argv[first + 3], threads))) {
+        cerr << "Usage: ./rc4_keysearch [--hex] <plaintext_file> <ciphertext_file> <key_bytes> [threads]\n"
+             << "       --hex reads the ciphertext in the cipherText.txt hexadecimal format\n";
+        return 1;
+    }
+
+    SearchState search;
+    search.plaintext = readFile(argv[first]);
+    search.ciphertext = readFile(argv[first + 1]);
+    if (hexInput) {
+        vector<uint8_t> decoded(search.ciphertext.size() / 2 + 1);
+        bool valid;
+        decoded.resize(hexDecode(reinterpret_cast<const char *>(search.ciphertext.data()), search.ciphertext.size(),
+                                 decoded.data(), &valid));
+        if (!valid) {
+            cerr << "Malformed hexadecimal text in " << argv[first + 1] << "\n";
+            return 1;
+        }
+        search.ciphertext = decoded;
+    }
+    if (keyBytes < 1 || keyBytes > 8 || threads == 0) {
+        cerr << "Key length must be 1 to 8 bytes and at least one thread is needed\n";
+        return 1;
+    }
+    size_t known = min(search.plaintext.size(), search.ciphertext.size());
+    if (known == 0) {
+        cerr << "Need at least one byte of known plaintext and ciphertext\n";
+        return 1;
+    }
+    if (known <= keyBytes) {
+        cerr << "Warning: only " << known << " known bytes for a " << keyBytes
+             << "-byte key; the first match may be a false positive\n";
+    }
+    search.plaintext.resize(known);
+    search.ciphertext.resize(known);
+    search.firstKeystreamByte = search.plaintext[0] ^ search.ciphertext[0];
+    search.lastKey = keyBytes == 8 ? ~0ULL : (1ULL << (8 * keyBytes)) - 1;
+
+    cout << "Searching 2^" << 8 * keyBytes << " keys of " << keyBytes << " bytes on " << threads << " threads" << endl;
+    auto start = chrono::steady_clock::now();
+    switch (keyBytes) {
+        case 1: runSearch<1>(search, threads); break;
+        case 2: runSearch<2>(search, threads); break;
+        case 3: runSearch<3>(search, threads); break;
+        case 4: runSearch<4>(search, threads); break;
+        case 5: runSearch<5>(search, threads); break;
+        case 6: runSearch<6>(search, threads); break;
+        case 7: runSearch<7>(search, threads); break;
+        case 8: runSearch<8>(search, threads); break;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (!search.found) {
+        cout << "No key found (" << seconds << " s)" << endl;
+        return 1;
+    }
+    cout << "Key found: ";
+    for (uint8_t b : search.key) {
+        cout << hex << uppercase << setfill('0') << setw(2) << (int)b;
+    }
+    cout << dec << " (" << fixed << setprecision(2) << seconds << " s)" << endl;
+    return 0;
+}
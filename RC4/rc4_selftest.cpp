@@ -0,0 +1,133 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <array>
+#include "rc4.h"
+#include "chacha20.h"
+#include "sha256.h"
+
+using namespace std;
+
+// Known-answer tests for the ciphers and the hash: published test vectors, plus long
+// ChaCha20 keystreams whose SHA-256 was computed with an independent implementation.
+// Every ChaCha20 kernel the CPU supports is run in several chunkings, since the vector
+// kernels only take whole 8- or 16-block runs and hand partial blocks to the scalar code.
+
+int failures = 0;
+
+// Function to turn a string of hex digits into bytes
+vector<uint8_t> fromHex(const string &hex) {
+    vector<uint8_t> bytes;
+    for (size_t x = 0; x + 1 < hex.size(); x += 2) {
+        bytes.push_back(stoi(hex.substr(x, 2), nullptr, 16));
+    }
+    return bytes;
+}
+
+// Function to record and print the result of one test
+void check(const string &name, const vector<uint8_t> &actual, const vector<uint8_t> &expected) {
+    bool pass = actual == expected;
+    cout << (pass ? "PASS " : "FAIL ") << name << endl;
+    if (!pass) failures++;
+}
+
+vector<uint8_t> digestOf(const vector<uint8_t> &data) {
+    array<uint8_t, 32> digest = sha256(data);
+    return vector<uint8_t>(digest.begin(), digest.end());
+}
+
+// FIPS 180-2 appendix B: one-block, two-block and long messages
+void testSha256() {
+    string abc = "abc";
+    string twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    check("SHA-256 \"abc\"", digestOf(vector<uint8_t>(abc.begin(), abc.end())),
+          fromHex("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+    check("SHA-256 448-bit message", digestOf(vector<uint8_t>(twoBlocks.begin(), twoBlocks.end())),
+          fromHex("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+    check("SHA-256 one million 'a'", digestOf(vector<uint8_t>(1000000, 'a')),
+          fromHex("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"));
+}
+
+// RFC 6229, 40-bit key 0x0102030405: keystream at offsets 0, 16 and 4096
+void testRc4() {
+    vector<uint8_t> key = fromHex("0102030405");
+    vector<uint8_t> expectedStart = fromHex("b2396305f03dc027ccc3524a0a1118a86982944f18fc82d589c403a47a0d0919");
+    vector<uint8_t> expectedAt4096 = fromHex("ff25b58995996707e51fbdf08b34d875");
+
+    vector<uint8_t> keystream = rc4EncryptDecrypt(vector<uint8_t>(4112), key);
+    check("RC4 RFC 6229 offset 0", vector<uint8_t>(keystream.begin(), keystream.begin() + 32), expectedStart);
+    check("RC4 RFC 6229 offset 4096", vector<uint8_t>(keystream.begin() + 4096, keystream.end()), expectedAt4096);
+
+    // Same keystream through the 16-lane engine, one lane per copy of the key
+    vector<vector<uint8_t>> keys(16, key), inputs(16, vector<uint8_t>(4112));
+    vector<vector<uint8_t>> lanes = rc4EncryptDecryptBatch<16>(inputs, keys);
+    bool same = true;
+    for (const vector<uint8_t> &lane : lanes) {
+        same = same && lane == keystream;
+    }
+    check("RC4 RFC 6229 16-lane engine", same ? keystream : vector<uint8_t>(), keystream);
+}
+
+// Function to run a ChaCha20 keystream of len bytes through update() in pieces of chunk bytes
+vector<uint8_t> chachaKeystream(const vector<uint8_t> &key, const vector<uint8_t> &nonce, uint32_t counter,
+                                size_t len, size_t chunk, ChaChaKernel kernel) {
+    ChaCha20Stream chacha(key.data(), nonce.data(), counter, kernel);
+    vector<uint8_t> out(len);
+    for (size_t off = 0; off < len; off += chunk) {
+        chacha.update(out.data() + off, out.data() + off, min(chunk, len - off));
+    }
+    return out;
+}
+
+// RFC 8439 section 2.4.2 on every kernel, then 4096-byte keystreams from counter 1 and from
+// 0xfffffff0, where the 32-bit block counter wraps and carries into the first nonce word
+void testChaCha20() {
+    vector<uint8_t> key = fromHex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    vector<uint8_t> nonce = fromHex("000000000000004a00000000");
+    string sunscreen = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, "
+                       "sunscreen would be it.";
+    vector<uint8_t> expected = fromHex(
+        "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0bf91b65c5524733ab8f593dabcd62b35716"
+        "39d624e65152ab8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab77937365af9"
+        "0bbf74a35be6b40b8eedf2785e42874d");
+    vector<uint8_t> longDigest = fromHex("03e37045b672bfe4c0c0265ac4ea21d51eda7e5de4f812ecc13bbdeaf7c9fa41");
+    vector<uint8_t> wrapDigest = fromHex("7540ec8143e262b881e624e6cd1c9ae2c1fa3429cbe853bf9561582188e7ab0b");
+
+    struct Kernel {
+        const char *name;
+        ChaChaKernel kernel;
+    };
+    const Kernel kernels[] = {
+        {"scalar", ChaChaKernel::Scalar}, {"AVX2", ChaChaKernel::Avx2}, {"AVX-512", ChaChaKernel::Avx512}};
+    for (const Kernel &k : kernels) {
+        if (k.kernel > chachaBestKernel()) {
+            cout << "SKIP ChaCha20 " << k.name << " (not supported by this CPU)" << endl;
+            continue;
+        }
+        string name = string("ChaCha20 ") + k.name;
+        vector<uint8_t> text(sunscreen.begin(), sunscreen.end());
+        ChaCha20Stream chacha(key.data(), nonce.data(), 1, k.kernel);
+        chacha.update(text.data(), text.data(), text.size());
+        check(name + " RFC 8439 2.4.2", text, expected);
+
+        for (size_t chunk : {4096, 1024, 100}) {
+            string pieces = " in " + to_string(chunk) + "-byte updates";
+            check(name + " counter 1" + pieces, digestOf(chachaKeystream(key, nonce, 1, 4096, chunk, k.kernel)),
+                  longDigest);
+            check(name + " counter wrap" + pieces,
+                  digestOf(chachaKeystream(key, nonce, 0xfffffff0, 4096, chunk, k.kernel)), wrapDigest);
+        }
+    }
+}
+
+int main() {
+    testSha256();
+    testRc4();
+    testChaCha20();
+    if (failures > 0) {
+        cout << failures << " test(s) failed" << endl;
+        return 1;
+    }
+    cout << "All tests passed" << endl;
+    return 0;
+}
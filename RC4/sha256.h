@@ -0,0 +1,89 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+// SHA-256 (FIPS 180-4), used to derive per-file keys and nonces in batch mode. Plain
+// scalar code: it hashes a key and a path per file, never the file contents.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <vector>
+
+inline uint32_t sha256Rotr(uint32_t v, int n) {
+    return (v >> n) | (v << (32 - n));
+}
+
+// Function to process one 64-byte block into the hash state h
+inline void sha256Block(uint32_t h[8], const uint8_t block[64]) {
+    static const uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+    uint32_t w[64];
+    for (int t = 0; t < 16; t++) {
+        w[t] = (uint32_t)block[4 * t] << 24 | (uint32_t)block[4 * t + 1] << 16 | (uint32_t)block[4 * t + 2] << 8 |
+               (uint32_t)block[4 * t + 3];
+    }
+    for (int t = 16; t < 64; t++) {
+        uint32_t s0 = sha256Rotr(w[t - 15], 7) ^ sha256Rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+        uint32_t s1 = sha256Rotr(w[t - 2], 17) ^ sha256Rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+        w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int t = 0; t < 64; t++) {
+        uint32_t t1 = k + (sha256Rotr(e, 6) ^ sha256Rotr(e, 11) ^ sha256Rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+        uint32_t t2 = (sha256Rotr(a, 2) ^ sha256Rotr(a, 13) ^ sha256Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+// Function to compute the SHA-256 digest of len bytes of data
+inline std::array<uint8_t, 32> sha256(const uint8_t *data, size_t len) {
+    uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    size_t full = len / 64 * 64;
+    for (size_t off = 0; off < full; off += 64) {
+        sha256Block(h, data + off);
+    }
+    // Padding: 0x80, zeros, then the bit length as a 64-bit big-endian number
+    uint8_t tail[128] = {};
+    size_t rest = len - full;
+    memcpy(tail, data + full, rest);
+    tail[rest] = 0x80;
+    size_t tailLen = rest < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int x = 0; x < 8; x++) {
+        tail[tailLen - 1 - x] = (uint8_t)(bits >> (8 * x));
+    }
+    for (size_t off = 0; off < tailLen; off += 64) {
+        sha256Block(h, tail + off);
+    }
+    std::array<uint8_t, 32> digest;
+    for (int x = 0; x < 8; x++) {
+        digest[4 * x] = (uint8_t)(h[x] >> 24);
+        digest[4 * x + 1] = (uint8_t)(h[x] >> 16);
+        digest[4 * x + 2] = (uint8_t)(h[x] >> 8);
+        digest[4 * x + 3] = (uint8_t)h[x];
+    }
+    return digest;
+}
+
+inline std::array<uint8_t, 32> sha256(const std::vector<uint8_t> &data) {
+    return sha256(data.data(), data.size());
+}
+
+#endif
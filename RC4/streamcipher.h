@@ -0,0 +1,16 @@
+#ifndef STREAMCIPHER_H
+#define STREAMCIPHER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Common interface of the stream ciphers the file, mmap, pipeline and batch modes can run
+class StreamCipher {
+public:
+    virtual ~StreamCipher() = default;
+
+    // XOR the next len keystream bytes into in and store the result in out (in and out may alias)
+    virtual void update(const uint8_t *in, uint8_t *out, size_t len) = 0;
+};
+
+#endif
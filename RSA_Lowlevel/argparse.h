@@ -0,0 +1,27 @@
+#ifndef ARGPARSE_H
+#define ARGPARSE_H
+
+#include <string>
+#include <limits>
+
+// Checked parsing of numeric command-line arguments. std::stoul throws on a typo such as
+// "x10" (ending the tool with an uncaught exception) and quietly takes the "10" of "10x";
+// the tools print their usage instead.
+
+// Function to parse a non-negative decimal argument into value; false unless the whole text
+// is such a number and it fits in T
+template <typename T>
+inline bool ParseUnsigned(const std::string& text, T& value) {
+    if (text.empty()) return false;
+    T parsed = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        T digit = c - '0';
+        if (parsed > (std::numeric_limits<T>::max() - digit) / 10) return false;
+        parsed = parsed * 10 + digit;
+    }
+    value = parsed;
+    return true;
+}
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef BATCHRSA_H
+#define BATCHRSA_H
+
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/integer.h>
+#include <cryptopp/nbtheory.h>
+#include <cryptopp/files.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "rsakey.h"
+
+// Experimental batch RSA (Fiat, "Batch RSA", Crypto '89; Shacham and Boneh, "Improving SSL
+// handshake performance via batching", CT-RSA 2001). Several public keys share n but have
+// distinct small prime exponents e_1 .. e_b. Ciphertexts c_i = m_i^e_i mod n for different
+// exponents can then be decrypted together for about the cost of one full exponentiation:
+//
+//   up:   a product tree combines the ciphertexts; a node over exponents with product E holds
+//         v = prod c_i^(E / e_i), so that v^(1/E) = prod m_i, and a parent of L and R holds
+//         v_L^E_R * v_R^E_L with E = E_L * E_R
+//   root: one exponentiation r = v^(E^-1 mod phi(n)) mod n, by CRT
+//   down: r = r_L * r_R at each node is split with X = 0 mod E_L, X = 1 mod E_R:
+//         r^X = v_L^(X / E_L) * r_R * v_R^((X - 1) / E_R), which gives r_R and then r_L = r / r_R
+//
+// All other exponents are at most the product of the batch's e_i, so their cost is small next
+// to the root exponentiation. Exponents must be distinct primes that do not divide phi(n).
+
+// Most public keys keygen --fiat makes for one modulus
+const size_t MAX_FIAT_EXPONENTS = 32;
+
+// Function to pick count public exponents for batch RSA: the odd primes from 17 up that do not
+// divide phi(n). Textbook RSA leaks m when m^e < n, so exponents below 17 are not used; with
+// e >= 17 a 2048-bit key needs messages longer than 120 bits (any session key qualifies).
+inline std::vector<CryptoPP::Integer> FiatExponents(const CryptoPP::Integer& phi_n, size_t count) {
+    std::vector<CryptoPP::Integer> exponents;
+    for (long e = 17; exponents.size() < count; e += 2) {
+        CryptoPP::Integer candidate(e);
+        if (CryptoPP::IsSmallPrime(candidate) && CryptoPP::RelativelyPrime(candidate, phi_n)) {
+            exponents.push_back(candidate);
+        }
+    }
+    return exponents;
+}
+
+// Function to compute phi(n) from the primes of a CRT key
+inline CryptoPP::Integer KeyPhi(const RsaPrivateKey& key) {
+    CryptoPP::Integer phi_n = CryptoPP::Integer::One();
+    for (size_t i = 0; i < CrtPrimeCount(key); i++) {
+        phi_n *= CrtPrime(key, i) - 1;
+    }
+    return phi_n;
+}
+
+// Function to read a public key file written by keygen --fiat: (e_1, n) followed by e_2 .. e_b.
+// Plain (e, n) files give a single exponent.
+inline std::vector<CryptoPP::Integer> LoadPublicExponents(const std::string& pubKeyFile, CryptoPP::Integer& n) {
+    std::vector<CryptoPP::Integer> exponents(1);
+    CryptoPP::FileSource pubFile(pubKeyFile.c_str(), true);
+    exponents[0].BERDecode(pubFile);
+    n.BERDecode(pubFile);
+    while (pubFile.AnyRetrievable()) {
+        exponents.emplace_back();
+        exponents.back().BERDecode(pubFile);
+    }
+    return exponents;
+}
+
+class FiatBatchDecryptor {
+public:
+    // key must have its CRT fields (the primes give phi(n) for any product of exponents)
+    explicit FiatBatchDecryptor(const RsaPrivateKey& key)
+        : key(key), phi_n(KeyPhi(key)), keyExponents(FiatExponents(phi_n, MAX_FIAT_EXPONENTS)),
+          engine(MakeModExpEngine(key.n)) {}
+
+    // Function to check that e is one of the exponents keygen --fiat can give this modulus
+    bool IsKeyExponent(const CryptoPP::Integer& e) const {
+        return std::find(keyExponents.begin(), keyExponents.end(), e) != keyExponents.end();
+    }
+
+    // Function to decrypt ciphertexts[i] made with exponents[i] into plain. Fails, leaving plain
+    // empty, if an exponent is not one of the key's or is repeated (they must be pairwise coprime),
+    // if a ciphertext is not in [1, n), or if a result does not re-encrypt to its ciphertext (a
+    // ciphertext sharing a factor with n has no inverse, which breaks the tree for the batch).
+    bool Decrypt(const std::vector<CryptoPP::Integer>& exponents, const std::vector<CryptoPP::Integer>& ciphertexts,
+                 std::vector<CryptoPP::Integer>& plain) const {
+        plain.clear();
+        if (exponents.size() != ciphertexts.size()) return false;
+        if (ciphertexts.empty()) return true;
+        CryptoPP::Integer product = CryptoPP::Integer::One();
+        for (size_t i = 0; i < ciphertexts.size(); i++) {
+            if (!IsKeyExponent(exponents[i]) || !CryptoPP::RelativelyPrime(exponents[i], product) ||
+                ciphertexts[i].IsZero() || ciphertexts[i].IsNegative() || ciphertexts[i] >= key.n) {
+                return false;
+            }
+            product *= exponents[i];
+        }
+        std::unique_ptr<Node> root = Build(exponents, ciphertexts, 0, ciphertexts.size());
+
+        // The one full-size exponentiation, by CRT with d_E = E^-1 mod phi(n) in place of d
+        std::vector<CryptoPP::Integer> primes;
+        for (size_t i = 0; i < CrtPrimeCount(key); i++) {
+            primes.push_back(CrtPrime(key, i));
+        }
+        CryptoPP::Integer dE = root->E.InverseMod(phi_n);
+        if (dE.IsZero()) return false;
+        RsaPrivateKey rootKey = MakePrivateKey(dE, primes);
+        plain.resize(ciphertexts.size());
+        bool ok = Percolate(*root, RsaPrivateOp(rootKey, root->v), plain);
+        // Each m_i^e_i costs a few multiplications; it catches any batch the tree got wrong
+        for (size_t i = 0; ok && i < ciphertexts.size(); i++) {
+            ok = engine->Exp(plain[i], exponents[i]) == ciphertexts[i];
+        }
+        if (!ok) plain.clear();
+        return ok;
+    }
+
+private:
+    // Product tree node for the messages [first, last)
+    struct Node {
+        size_t first, last;
+        CryptoPP::Integer E, v;
+        std::unique_ptr<Node> left, right;
+    };
+
+    CryptoPP::Integer MulMod(const CryptoPP::Integer& a, const CryptoPP::Integer& b) const {
+        return a * b % key.n;
+    }
+
+    std::unique_ptr<Node> Build(const std::vector<CryptoPP::Integer>& exponents,
+                                const std::vector<CryptoPP::Integer>& ciphertexts, size_t first, size_t last) const {
+        std::unique_ptr<Node> node(new Node{first, last, CryptoPP::Integer(), CryptoPP::Integer(), nullptr, nullptr});
+        if (last - first == 1) {
+            node->E = exponents[first];
+            node->v = ciphertexts[first];
+            return node;
+        }
+        size_t middle = first + (last - first) / 2;
+        node->left = Build(exponents, ciphertexts, first, middle);
+        node->right = Build(exponents, ciphertexts, middle, last);
+        node->E = node->left->E * node->right->E;
+        node->v = MulMod(engine->Exp(node->left->v, node->right->E), engine->Exp(node->right->v, node->left->E));
+        return node;
+    }
+
+    // r = node.v^(1/node.E) mod n; false if a value on the way has no inverse
+    bool Percolate(const Node& node, const CryptoPP::Integer& r, std::vector<CryptoPP::Integer>& plain) const {
+        if (!node.left) {
+            plain[node.first] = r;
+            return true;
+        }
+        const Node& L = *node.left;
+        const Node& R = *node.right;
+        CryptoPP::Integer inverseL = L.E.InverseMod(R.E);
+        if (inverseL.IsZero()) return false;
+        CryptoPP::Integer X = L.E * inverseL;  // X = 0 mod E_L, X = 1 mod E_R
+        CryptoPP::Integer known = MulMod(engine->Exp(L.v, X / L.E), engine->Exp(R.v, (X - 1) / R.E));
+        CryptoPP::Integer knownInv = known.InverseMod(key.n);
+        if (knownInv.IsZero()) return false;
+        CryptoPP::Integer rR = MulMod(engine->Exp(r, X), knownInv);
+        CryptoPP::Integer rRInv = rR.InverseMod(key.n);
+        if (rRInv.IsZero()) return false;
+        CryptoPP::Integer rL = MulMod(r, rRInv);
+        return Percolate(L, rL, plain) && Percolate(R, rR, plain);
+    }
+
+    RsaPrivateKey key;
+    CryptoPP::Integer phi_n;
+    std::vector<CryptoPP::Integer> keyExponents;  // FiatExponents(phi_n, MAX_FIAT_EXPONENTS)
+    std::unique_ptr<ModExpEngine> engine;
+};
+
+#endif
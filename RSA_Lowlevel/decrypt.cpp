@@ -5,33 +5,36 @@
 #include <cryptopp/files.h>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <chrono>
 #include <ctime> //time
+#include "rsakey.h"
+#include "rsablocks.h"
+#include "batchrsa.h"
+#include "argparse.h"
 
 using namespace CryptoPP;
 
-void Decrypt(const std::string& privKeyFile, const std::string& cipherFile, const std::string& outFile) {
-    // Read private key (d, n) from binary file
-    Integer d, n;
-    FileSource privFile(privKeyFile.c_str(), true);
-    d.BERDecode(privFile);
-    n.BERDecode(privFile);
+void Decrypt(const std::string& privKeyFile, const std::string& cipherFile, const std::string& outFile,
+             bool parallelCrt) {
+    // Read private key (d, n), plus the CRT fields if the key file has them
+    RsaPrivateKey key = LoadPrivateKey(privKeyFile);
 
     // Read ciphertext from binary file
     Integer C;
     FileSource cipherSource(cipherFile.c_str(), true);
     C.BERDecode(cipherSource);
 
-    // Perform decryption: m = C^d mod n
-    clock_t startTime, endTime; //time
-    double elapsed_time; //time
-    double avgTimeTaken, totalTimeTaken = 0.0; //time
-    startTime = clock();
+    // Perform decryption: m = C^d mod n (by CRT when the key has p and q, with the halves on two
+    // cores when parallelCrt is set)
+    // Wall-clock time: clock() would add up the CPU time of the per-prime threads
+    auto startTime = std::chrono::steady_clock::now(); //time
 
-    Integer m = a_exp_b_mod_c(C, d, n);
+    Integer m = RsaPrivateOp(key, C, parallelCrt);
 
-    endTime = clock();
-    elapsed_time = static_cast<double>(endTime - startTime)/CLOCKS_PER_SEC*1000;
-    totalTimeTaken = (totalTimeTaken + elapsed_time);
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count(); //time
     std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
 
     // Convert the decrypted integer back to string (plaintext)
@@ -47,13 +50,178 @@ void Decrypt(const std::string& privKeyFile, const std::string& cipherFile, cons
     out.close();
 }
 
+// Block mode: decrypts a block stream written by encrypt --blocks, blocks in parallel
+bool DecryptBlocksFile(const std::string& privKeyFile, const std::string& cipherFile, const std::string& outFile,
+                       unsigned threads) {
+    RsaPrivateKey key = LoadPrivateKey(privKeyFile);
+
+    std::ifstream in(cipherFile, std::ios::binary);
+    std::string stream((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // Wall-clock time, since the blocks run on several threads
+    auto startTime = std::chrono::steady_clock::now(); //time
+    std::string plain;
+    bool ok = DecryptBlocks(key, stream, plain, threads);
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    if (!ok) {
+        std::cerr << "Not a block stream for this key: " << cipherFile << "\n";
+        return false;
+    }
+    std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
+
+    std::ofstream out(outFile, std::ios::binary);
+    out.write(plain.data(), plain.size());
+    return true;
+}
+
+// Batch mode: the key is read and its engines set up once, then all ciphertexts in the file
+// (as written by encrypt --batch) are decrypted together, several per vector operation, to one
+// line of the output each. A ciphertext that cannot be decoded or is not in [0, n) stops the
+// run before dec_msg.txt is written.
+bool DecryptBatch(const std::string& privKeyFile, const std::string& cipherFile, const std::string& outFile) {
+    RsaPrivateContext priv(LoadPrivateKey(privKeyFile));
+    FileSource cipherSource(cipherFile.c_str(), true);
+
+    auto startTime = std::chrono::steady_clock::now(); //time
+    std::vector<Integer> ciphertexts;
+    while (cipherSource.AnyRetrievable()) {
+        Integer C;
+        try {
+            C.BERDecode(cipherSource);
+        } catch (const Exception&) {
+            std::cerr << "Error: ciphertext " << ciphertexts.size() + 1 << " in " << cipherFile
+                      << " is not a DER-encoded integer\n";
+            return false;
+        }
+        if (C.IsNegative() || C >= priv.key.n) {
+            std::cerr << "Error: ciphertext " << ciphertexts.size() + 1 << " is not smaller than the modulus\n";
+            return false;
+        }
+        ciphertexts.push_back(C);
+    }
+    size_t count = ciphertexts.size();
+    std::string decoded;
+    for (const Integer& m : priv.ApplyAll(ciphertexts)) {
+        std::string decodedMessage(m.MinEncodedSize(), '\0');
+        m.Encode((byte*)decodedMessage.data(), decodedMessage.size());
+        decoded += decodedMessage + "\n";
+    }
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
+    std::cout << count << " messages decrypted (" << count / (totalTimeTaken / 1000) << " ops/s, "
+              << priv.BatchKernel() << ")" << std::endl;
+
+    std::ofstream out(outFile);
+    out << decoded;
+    return true;
+}
+
+// Batch RSA mode: decrypts the (e, C) pairs written by encrypt --fiat. Consecutive ciphertexts
+// under pairwise coprime exponents form one batch, which costs about one full exponentiation in
+// all (batchrsa.h); an exponent sharing a factor with the batch so far starts the next one.
+// Every exponent must be one of the key's batch exponents. Any bad pair or failed batch stops
+// the run before dec_msg.txt is written.
+bool DecryptFiat(const std::string& privKeyFile, const std::string& cipherFile, const std::string& outFile) {
+    RsaPrivateKey key = LoadPrivateKey(privKeyFile);
+    if (!key.hasCrt) {
+        std::cerr << "Batch RSA needs a key file with the CRT fields\n";
+        return false;
+    }
+    FiatBatchDecryptor decryptor(key);
+    FileSource cipherSource(cipherFile.c_str(), true);
+
+    auto startTime = std::chrono::steady_clock::now(); //time
+    std::vector<Integer> exponents, ciphertexts, plain;
+    Integer product = Integer::One();
+    std::string decoded;
+    size_t count = 0, batches = 0;
+    auto flush = [&] {
+        if (!decryptor.Decrypt(exponents, ciphertexts, plain)) {
+            std::cerr << "Batch of ciphertexts " << count + 1 << " to " << count + ciphertexts.size()
+                      << " failed to decrypt (a ciphertext out of range or not made with this key)\n";
+            return false;
+        }
+        for (const Integer& m : plain) {
+            std::string decodedMessage(m.MinEncodedSize(), '\0');
+            m.Encode((byte*)decodedMessage.data(), decodedMessage.size());
+            decoded += decodedMessage + "\n";
+        }
+        count += ciphertexts.size();
+        batches++;
+        exponents.clear();
+        ciphertexts.clear();
+        product = Integer::One();
+        return true;
+    };
+    while (cipherSource.AnyRetrievable()) {
+        Integer e, C;
+        try {
+            e.BERDecode(cipherSource);
+            C.BERDecode(cipherSource);
+        } catch (const Exception&) {
+            std::cerr << "Error: pair " << count + ciphertexts.size() + 1 << " in " << cipherFile
+                      << " is not a DER-encoded (e, C) pair\n";
+            return false;
+        }
+        if (!decryptor.IsKeyExponent(e)) {
+            std::cerr << "Ciphertext " << count + ciphertexts.size() + 1
+                      << " uses an exponent that is not a batch exponent of this key\n";
+            return false;
+        }
+        if (!RelativelyPrime(e, product) && !flush()) return false;
+        exponents.push_back(e);
+        ciphertexts.push_back(C);
+        product *= e;
+    }
+    if (!ciphertexts.empty() && !flush()) return false;
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
+    std::cout << count << " messages decrypted in " << batches << " batches (" << count / (totalTimeTaken / 1000)
+              << " ops/s)" << std::endl;
+
+    std::ofstream out(outFile);
+    out << decoded;
+    return true;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--fiat") {
+        if (argc != 4) {
+            std::cerr << "Usage: ./decrypt --fiat <private_key_file> <cipher_file>\n";
+            return 1;
+        }
+        return DecryptFiat(argv[2], argv[3], "dec_msg.txt") ? 0 : 1;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        if (argc != 4) {
+            std::cerr << "Usage: ./decrypt --batch <private_key_file> <cipher_file>\n";
+            return 1;
+        }
+        return DecryptBatch(argv[2], argv[3], "dec_msg.txt") ? 0 : 1;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--blocks") {
+        unsigned threads = 0;
+        if ((argc != 4 && argc != 5) || (argc == 5 && !ParseUnsigned(argv[4], threads))) {
+            std::cerr << "Usage: ./decrypt --blocks <private_key_file> <cipher_file> [threads]\n";
+            return 1;
+        }
+        return DecryptBlocksFile(argv[2], argv[3], "dec_msg.txt", threads) ? 0 : 1;
+    }
+    // --parallel-crt runs the two CRT exponentiations on two cores (persistent thread pool)
+    bool parallelCrt = argc > 1 && std::string(argv[1]) == "--parallel-crt";
+    if (parallelCrt) {
+        argv++;
+        argc--;
+    }
     if (argc != 3) {
-        std::cerr << "Usage: ./decrypt <private_key_file> <cipher_file>\n";
+        std::cerr << "Usage: ./decrypt [--parallel-crt] <private_key_file> <cipher_file>\n"
+                  << "       ./decrypt --blocks <private_key_file> <cipher_file> [threads]\n"
+                  << "       ./decrypt --batch <private_key_file> <cipher_file>\n"
+                  << "       ./decrypt --fiat <private_key_file> <cipher_file>\n";
         return 1;
     }
 
-    Decrypt(argv[1], argv[2], "dec_msg.txt");
+    Decrypt(argv[1], argv[2], "dec_msg.txt", parallelCrt);
     return 0;
 }
 
@@ -5,11 +5,19 @@
 #include <cryptopp/files.h>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <chrono>
 #include <ctime> //time
+#include "rsakey.h"
+#include "rsablocks.h"
+#include "batchrsa.h"
+#include "argparse.h"
 
 using namespace CryptoPP;
 
-void Encrypt(const std::string& pubKeyFile, const std::string& dataFile, const std::string& cipherFile) {
+bool Encrypt(const std::string& pubKeyFile, const std::string& dataFile, const std::string& cipherFile) {
     // Read public key (e, n) from binary file
     Integer e, n;
     FileSource pubFile(pubKeyFile.c_str(), true); //FileSource is a class that reads data from a file.
@@ -24,8 +32,10 @@ void Encrypt(const std::string& pubKeyFile, const std::string& dataFile, const s
 
     // Convert message to Integer (plaintext)
     Integer m((const byte*)message.data(), message.size());//message.data() returns a pointer to the raw byte data(typecast)
-    if(m>n){
-      m=m%n;
+    // m must be smaller than n, otherwise decryption gives back m mod n instead of the message
+    if(m>=n){
+      std::cerr << "Error: the message is not smaller than the modulus; use --blocks for long inputs\n";
+      return false;
       }
     // Perform encryption: C = m^e mod n
     clock_t startTime, endTime; //time
@@ -33,7 +43,7 @@ void Encrypt(const std::string& pubKeyFile, const std::string& dataFile, const s
     double avgTimeTaken, totalTimeTaken = 0.0; //time
     startTime = clock();
 
-    Integer C = a_exp_b_mod_c(m, e, n);
+    Integer C = ModExp(m, e, n);
 
     endTime = clock();
     elapsed_time = static_cast<double>(endTime - startTime)/CLOCKS_PER_SEC*1000;
@@ -45,15 +55,133 @@ void Encrypt(const std::string& pubKeyFile, const std::string& dataFile, const s
     FileSink cipherSink(cipherFile.c_str());
     C.DEREncode(cipherSink);
     cipherSink.MessageEnd();
+    return true;
+}
+
+// Block mode: the whole data file (any length, binary or text) is split into modulus-sized
+// blocks that are encrypted concurrently and written as a length-prefixed block stream
+void EncryptBlocksFile(const std::string& pubKeyFile, const std::string& dataFile, const std::string& cipherFile,
+                       unsigned threads) {
+    // Read public key (e, n) from binary file
+    Integer e, n;
+    FileSource pubFile(pubKeyFile.c_str(), true);
+    e.BERDecode(pubFile);
+    n.BERDecode(pubFile);
+
+    std::ifstream in(dataFile, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // Wall-clock time, since the blocks run on several threads
+    auto startTime = std::chrono::steady_clock::now(); //time
+    std::string stream = EncryptBlocks(e, n, data, threads);
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
+
+    std::ofstream out(cipherFile, std::ios::binary);
+    out.write(stream.data(), stream.size());
+    std::cout << data.size() << " bytes encrypted in " << (data.size() + n.ByteCount() - 2) / (n.ByteCount() - 1)
+              << " blocks.\n";
+}
+
+// Batch mode: the key is read and its Montgomery context set up once, then every line of
+// the messages file is encrypted; cipher.bin holds one DER-encoded ciphertext per line.
+// A line that is not smaller than the modulus could not be decrypted back, so it stops the
+// run before anything is written.
+bool EncryptBatch(const std::string& pubKeyFile, const std::string& messagesFile, const std::string& cipherFile) {
+    RsaPublicContext pub = LoadPublicContext(pubKeyFile);
+    std::ifstream in(messagesFile);
+
+    auto startTime = std::chrono::steady_clock::now(); //time
+    std::vector<Integer> messages;
+    std::string message;
+    while (std::getline(in, message)) {
+        Integer m((const byte*)message.data(), message.size());
+        if (m >= pub.n) {
+            std::cerr << "Error: message " << messages.size() + 1
+                      << " is not smaller than the modulus; use --blocks for long inputs\n";
+            return false;
+        }
+        messages.push_back(m);
+    }
+    FileSink cipherSink(cipherFile.c_str());
+    for (const Integer& m : messages) {
+        pub.Apply(m).DEREncode(cipherSink);
+    }
+    cipherSink.MessageEnd();
+    size_t count = messages.size();
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
+    std::cout << count << " messages encrypted (" << count / (totalTimeTaken / 1000) << " ops/s)" << std::endl;
+    return true;
+}
+
+// Batch RSA mode: a public key file from keygen --fiat holds b exponents sharing n; line i of
+// the messages file is encrypted under e_(i mod b), as if by b different senders' keys.
+// cipher.bin holds a DER-encoded (e, C) pair per line so that decrypt --fiat can batch them.
+// As in --batch, a line not smaller than the modulus stops the run before anything is written.
+bool EncryptFiat(const std::string& pubKeyFile, const std::string& messagesFile, const std::string& cipherFile) {
+    Integer n;
+    std::vector<Integer> exponents = LoadPublicExponents(pubKeyFile, n);
+    std::unique_ptr<ModExpEngine> engine = MakeModExpEngine(n);
+    std::ifstream in(messagesFile);
+
+    auto startTime = std::chrono::steady_clock::now(); //time
+    std::vector<Integer> messages;
+    std::string message;
+    while (std::getline(in, message)) {
+        Integer m((const byte*)message.data(), message.size());
+        if (m >= n) {
+            std::cerr << "Error: message " << messages.size() + 1
+                      << " is not smaller than the modulus; use --blocks for long inputs\n";
+            return false;
+        }
+        messages.push_back(m);
+    }
+    FileSink cipherSink(cipherFile.c_str());
+    for (size_t i = 0; i < messages.size(); i++) {
+        const Integer& e = exponents[i % exponents.size()];
+        e.DEREncode(cipherSink);
+        engine->Exp(messages[i], e).DEREncode(cipherSink);
+    }
+    cipherSink.MessageEnd();
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
+    std::cout << messages.size() << " messages encrypted under " << exponents.size() << " exponents" << std::endl;
+    return true;
 }
 
 int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--fiat") {
+        if (argc != 4) {
+            std::cerr << "Usage: ./encrypt --fiat <public_key_file> <messages_file>\n";
+            return 1;
+        }
+        return EncryptFiat(argv[2], argv[3], "cipher.bin") ? 0 : 1;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        if (argc != 4) {
+            std::cerr << "Usage: ./encrypt --batch <public_key_file> <messages_file>\n";
+            return 1;
+        }
+        return EncryptBatch(argv[2], argv[3], "cipher.bin") ? 0 : 1;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--blocks") {
+        unsigned threads = 0;
+        if ((argc != 4 && argc != 5) || (argc == 5 && !ParseUnsigned(argv[4], threads))) {
+            std::cerr << "Usage: ./encrypt --blocks <public_key_file> <data_file> [threads]\n";
+            return 1;
+        }
+        EncryptBlocksFile(argv[2], argv[3], "cipher.bin", threads);
+        return 0;
+    }
     if (argc != 3) {
-        std::cerr << "Usage: ./encrypt <public_key_file> <data_file>\n";
+        std::cerr << "Usage: ./encrypt <public_key_file> <data_file>\n"
+                  << "       ./encrypt --blocks <public_key_file> <data_file> [threads]\n"
+                  << "       ./encrypt --batch <public_key_file> <messages_file>\n"
+                  << "       ./encrypt --fiat <public_key_file> <messages_file>\n";
         return 1;
     }
 
-    Encrypt(argv[1], argv[2], "cipher.bin");
-    return 0;
+    return Encrypt(argv[1], argv[2], "cipher.bin") ? 0 : 1;
 }
 
@@ -30,7 +30,7 @@ for (( i=1; i<=ITERATIONS; i++ ))
 
             # Compile the keygen.cpp file
             echo "Compiling keygen.cpp..."
-            g++ keygen.cpp -o keygen -lcryptopp
+            g++ -O2 keygen.cpp -o keygen -lcryptopp -pthread
 
             # Check if keygen compilation was successful
             if [ $? -eq 0 ]; then
@@ -44,7 +44,7 @@ for (( i=1; i<=ITERATIONS; i++ ))
 
                 # Compile the encrypt.cpp file
                 echo "Compiling encrypt.cpp..."
-                g++ encrypt.cpp -o encrypt -lcryptopp
+                g++ -O2 encrypt.cpp -o encrypt -lcryptopp -pthread
 
                 # Check if encrypt compilation was successful
                 if [ $? -eq 0 ]; then
@@ -58,7 +58,7 @@ for (( i=1; i<=ITERATIONS; i++ ))
 
                     # Compile the decrypt.cpp file
                     echo "Compiling decrypt.cpp..."
-                    g++ decrypt.cpp -o decrypt -lcryptopp
+                    g++ -O2 decrypt.cpp -o decrypt -lcryptopp -pthread
 
                     # Check if decrypt compilation was successful
                     if [ $? -eq 0 ]; then
@@ -4,56 +4,25 @@
 #include <cryptopp/nbtheory.h>
 #include <cryptopp/files.h>
 #include <iostream>
-#include <ctime> //time
+#include <string>
+#include <cctype>
+#include <chrono> //time
+#include "rsakeygen.h"
+#include "argparse.h"
 
 using namespace CryptoPP;
 
+void KeyGen(const std::string& pubKeyFile, const std::string& privKeyFile, const KeyGenOptions& options) {
+    // Wall-clock time: clock() would add up the CPU time of all prime search threads
+    auto startTime = std::chrono::steady_clock::now(); //time
 
+    // Primes, n, e and d (rsakeygen.h)
+    RsaKeyPair keys = GenerateKeyPair(options);
+    const Integer& e = keys.e;
+    //n is used in both encryption and decryption. The size of n dictates the security strength of the cryptosystem. one way fuction.
+    const Integer& n = keys.priv.n;
 
-void KeyGen(const std::string& pubKeyFile, const std::string& privKeyFile) {
-    clock_t startTime, endTime; //time
-    double elapsed_time; //time
-    double avgTimeTaken, totalTimeTaken = 0.0; //time
-    startTime = clock();
-
-    AutoSeededRandomPool rng;  //class provided by the Crypto++ library that is responsible for generating cryptographically secure random numbers.
-
-    // Generate two large primes
-    PrimeAndGenerator primeGen;
-    //1 tells the function to generate a safe prime.
-    //rng is the random number generator.
-    //primeBits is the bit size of the prime number.
-    //generatorBits is the bit size of the generator, which in RSA isn't typically needed.
-    primeGen.Generate(1, rng, 1024, 1023);
-    Integer p = primeGen.Prime();
-    primeGen.Generate(1, rng, 1024, 1023);
-    Integer q = primeGen.Prime();
-    
-    while(p==q){
-        //p = primeGen.Prime();
-        q = primeGen.Prime();
-    }
-
-    // Compute n = p * q
-    //used in both encryption and decryption. The size of n dictates the security strength of the cryptosystem. one way fuction.
-    Integer n = p * q;
-    
-    // Compute phi(n) = (p - 1)(q - 1)
-    Integer phi_n = (p - 1) * (q - 1); // ---
-
-    // Choose e such that 1 < d < phi_n and gcd(d, phi_n) = 1
-    Integer d;
-    do {
-        d.Randomize(rng, Integer::One(), phi_n - 1);
-    } while (!RelativelyPrime(d, phi_n));
-
-    // Calculate public key e
-    Integer e = d.InverseMod(phi_n);
-
-    endTime = clock();
-    elapsed_time = static_cast<double>(endTime - startTime)/CLOCKS_PER_SEC*1000;
-    totalTimeTaken = (totalTimeTaken + elapsed_time);
-    // avgTimeTaken = (totalTimeTaken / n);
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count(); //time
     std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
 
     // Write public key to file (e, n) in binary format
@@ -61,24 +30,68 @@ void KeyGen(const std::string& pubKeyFile, const std::string& privKeyFile) {
         FileSink pub(pubKeyFile.c_str());//FileSink is a class that writes data to a file.
         e.DEREncode(pub); //encode integers(e,n) in DER (Distinguished Encoding Rules) format.
         n.DEREncode(pub);
+        // Batch RSA: the further public exponents e_2 .. e_b follow (e, n); tools that read
+        // only (e, n) see the key for e_1
+        for (const Integer& extra : keys.batchExponents) {
+            extra.DEREncode(pub);
+        }
         pub.MessageEnd();// signals the end of the message or stream
     }
 
-    // Write private key to file (d, n) in binary format
-    {
-        FileSink priv(privKeyFile.c_str());
-        d.DEREncode(priv);
-        n.DEREncode(priv);
-        priv.MessageEnd();
-    }
+    // Write private key to file (d, n, p, q, dP, dQ, qInv, then (r, d_r, t) per further prime)
+    // in binary format; the CRT fields let decrypt and sign work modulo each prime separately
+    SavePrivateKey(privKeyFile, keys.priv);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    KeyGenOptions options;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--small-e") {
+            // --small-e [e] fixes the public exponent (65537 by default) instead of deriving it from a random d
+            bool given = a + 1 < argc && isdigit((unsigned char)argv[a + 1][0]);
+            options.publicExponent = given ? Integer(argv[++a]) : Integer(DEFAULT_SMALL_E);
+            if (options.publicExponent < 3 || options.publicExponent.IsEven()) {
+                std::cerr << "The public exponent must be odd and at least 3\n";
+                return 1;
+            }
+        } else if (arg == "--bits" && a + 1 < argc && ParseUnsigned(argv[a + 1], options.modulusBits)) {
+            a++;
+        } else if (arg == "--safe") {
+            options.safePrimes = true;
+        } else if (arg == "--threads" && a + 1 < argc && ParseUnsigned(argv[a + 1], options.threads)) {
+            a++;
+        } else if (arg == "--primes" && a + 1 < argc && ParseUnsigned(argv[a + 1], options.primes)) {
+            a++;
+        } else if (arg == "--fiat" && a + 1 < argc && ParseUnsigned(argv[a + 1], options.batchExponents)) {
+            // --fiat <b> makes b public keys sharing n, with distinct small prime exponents
+            a++;
+        } else {
+            std::cerr << "Usage: ./rsa_keygen_manual [--small-e [e]] [--bits <modulus_bits>] [--primes <2-4>] [--safe]\n"
+                      << "                          [--threads <n>] [--fiat <b>]\n";
+            return 1;
+        }
+    }
+    // Each prime keeps at least 512 bits, so factoring methods that find small factors
+    // (ECM) stay out of reach; with two primes this makes 1024 bits the smallest modulus
+    if (options.primes < 2 || options.primes > 4 || options.modulusBits / options.primes < 512) {
+        std::cerr << "Use 2 to 4 primes of at least 512 bits each: a modulus of at least 1024 bits (1536 for 3 primes,\n"
+                  << "2048 for 4)\n";
+        return 1;
+    }
+
+    if (options.batchExponents > 0 &&
+        (options.batchExponents > MAX_FIAT_EXPONENTS || !options.publicExponent.IsZero())) {
+        std::cerr << "--fiat takes 1 to " << MAX_FIAT_EXPONENTS << " exponents and picks them itself (no --small-e)\n";
+        return 1;
+    }
+
     try {
-        KeyGen("public_key.bin", "private_key.bin");
+        KeyGen("public_key.bin", "private_key.bin", options);
         std::cout << "Keys generated successfully.\n";
     } catch (const Exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
     }
     return 0;
 }
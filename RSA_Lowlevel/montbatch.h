@@ -0,0 +1,287 @@
+#ifndef MONTBATCH_H
+#define MONTBATCH_H
+
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/integer.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <immintrin.h>
+#include "montexp.h"
+
+// Multi-buffer modular exponentiation: several independent x^e mod m with the same m and e
+// (a batch of decryptions or signatures under one key) run together, one operand per vector
+// lane. Operands are split into radix-2^w digits, stored digit-major so that digit j of every
+// lane forms one vector, and multiplied with "almost Montgomery" multiplication: results stay
+// below 2m instead of m (R = 2^(w * Digits) > 4m), which removes the final subtraction from
+// the inner loop, and are fully reduced once at the end.
+//
+//   AVX-512 IFMA: 8 lanes, w = 52; vpmadd52luq/vpmadd52huq give the low and high 52 bits of
+//                 each digit product
+//   AVX2:         4 lanes, w = 28; vpmuludq gives the whole 56-bit product, and with at most
+//                 74 digits the 64-bit accumulators cannot overflow
+//
+// The kernels are compiled with target attributes, so no -m flags are needed, and chosen at
+// run time from the CPU features. Other CPUs, and moduli over 2048 bits, use the scalar engine
+// of montexp.h message by message.
+
+#define MONTBATCH_IFMA __attribute__((target("avx512f,avx512ifma")))
+#define MONTBATCH_AVX2 __attribute__((target("avx2")))
+
+// Function to split x (0 <= x < 2^(w * digits)) into radix-2^w digits, written to
+// out[0], out[stride], out[2 * stride], ...
+inline void IntegerToDigits(const CryptoPP::Integer& x, unsigned w, size_t digits, uint64_t* out, size_t stride) {
+    size_t limbs = (w * digits + 63) / 64;
+    std::vector<uint64_t> words(limbs + 1, 0);
+    IntegerToLimbs(x, words.data(), limbs);
+    const uint64_t mask = (1ULL << w) - 1;
+    for (size_t j = 0; j < digits; j++) {
+        size_t bit = j * w, word = bit / 64, shift = bit % 64;
+        uint64_t digit = words[word] >> shift;
+        if (shift + w > 64) digit |= words[word + 1] << (64 - shift);
+        out[j * stride] = digit & mask;
+    }
+}
+
+// Function to rebuild an Integer from radix-2^w digits (each below 2^w)
+inline CryptoPP::Integer DigitsToInteger(const uint64_t* in, size_t stride, unsigned w, size_t digits) {
+    size_t limbs = (w * digits + 63) / 64;
+    std::vector<uint64_t> words(limbs + 1, 0);
+    for (size_t j = 0; j < digits; j++) {
+        size_t bit = j * w, word = bit / 64, shift = bit % 64;
+        words[word] |= in[j * stride] << shift;
+        if (shift + w > 64) words[word + 1] |= in[j * stride] >> (64 - shift);
+    }
+    return LimbsToInteger(words.data(), limbs);
+}
+
+// 8 lanes of radix 2^52 with AVX-512 IFMA. The accumulator X holds 2 * Digits digits and is
+// not shifted: outer step i picks q = (X[i] + a[0] * b[i]) * k0 mod 2^52, then adds a * b[i]
+// and q * n at digit i in one pass, low halves at i + j and high halves at i + j + 1. X[i] is
+// then divisible by 2^52 and its carry moves up to X[i + 1]; X[Digits..] is the result.
+// (GCC 12 flags _mm512_setzero_si512 as reading an uninitialized value; it does not)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+struct IfmaKernel {
+    static const size_t Lanes = 8;
+    static const unsigned Radix = 52;
+
+    template <size_t Digits>
+    static MONTBATCH_IFMA void MontMul(uint64_t* r, const uint64_t* a, const uint64_t* b, const uint64_t* n,
+                                       uint64_t k0) {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i mask = _mm512_set1_epi64((1ULL << Radix) - 1);
+        const __m512i K0 = _mm512_set1_epi64(k0);
+        __m512i X[2 * Digits + 1];
+        for (size_t j = 0; j < 2 * Digits + 1; j++) X[j] = zero;
+
+        for (size_t i = 0; i < Digits; i++) {
+            const __m512i bi = _mm512_loadu_si512(b + i * Lanes);
+            const __m512i q = _mm512_madd52lo_epu64(zero, _mm512_madd52lo_epu64(X[i], _mm512_loadu_si512(a), bi), K0);
+            for (size_t j = 0; j < Digits; j++) {
+                const __m512i aj = _mm512_loadu_si512(a + j * Lanes);
+                const __m512i nj = _mm512_loadu_si512(n + j * Lanes);
+                X[i + j] = _mm512_madd52lo_epu64(_mm512_madd52lo_epu64(X[i + j], aj, bi), nj, q);
+                X[i + j + 1] = _mm512_madd52hi_epu64(_mm512_madd52hi_epu64(X[i + j + 1], aj, bi), nj, q);
+            }
+            X[i + 1] = _mm512_add_epi64(X[i + 1], _mm512_srli_epi64(X[i], Radix));
+        }
+
+        // Carry propagation back to digits below 2^52
+        __m512i carry = zero;
+        for (size_t j = 0; j < Digits; j++) {
+            const __m512i v = _mm512_add_epi64(X[Digits + j], carry);
+            carry = _mm512_srli_epi64(v, Radix);
+            _mm512_storeu_si512(r + j * Lanes, _mm512_and_si512(v, mask));
+        }
+    }
+};
+#pragma GCC diagnostic pop
+
+// 4 lanes of radix 2^28 with AVX2, same scheme. The digit products are added whole: one digit
+// position collects at most 2 * Digits products below 2^56 (< 2^64 for Digits <= 74), so the
+// split into low and high halves that IFMA needs is not necessary here.
+struct Avx2Kernel {
+    static const size_t Lanes = 4;
+    static const unsigned Radix = 28;
+
+    template <size_t Digits>
+    static MONTBATCH_AVX2 void MontMul(uint64_t* r, const uint64_t* a, const uint64_t* b, const uint64_t* n,
+                                       uint64_t k0) {
+        static_assert(Digits <= 74, "64-bit accumulators would overflow");
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i mask = _mm256_set1_epi64x((1ULL << Radix) - 1);
+        const __m256i K0 = _mm256_set1_epi64x(k0);
+        __m256i X[2 * Digits];
+        for (size_t j = 0; j < 2 * Digits; j++) X[j] = zero;
+
+        for (size_t i = 0; i < Digits; i++) {
+            const __m256i bi = _mm256_loadu_si256((const __m256i*)(b + i * Lanes));
+            const __m256i a0b = _mm256_mul_epu32(_mm256_loadu_si256((const __m256i*)a), bi);
+            const __m256i q = _mm256_and_si256(_mm256_mul_epu32(_mm256_add_epi64(X[i], a0b), K0), mask);
+            for (size_t j = 0; j < Digits; j++) {
+                const __m256i aj = _mm256_loadu_si256((const __m256i*)(a + j * Lanes));
+                const __m256i nj = _mm256_loadu_si256((const __m256i*)(n + j * Lanes));
+                X[i + j] = _mm256_add_epi64(X[i + j], _mm256_add_epi64(_mm256_mul_epu32(aj, bi), _mm256_mul_epu32(nj, q)));
+            }
+            X[i + 1] = _mm256_add_epi64(X[i + 1], _mm256_srli_epi64(X[i], Radix));
+        }
+
+        __m256i carry = zero;
+        for (size_t j = 0; j < Digits; j++) {
+            const __m256i v = _mm256_add_epi64(X[Digits + j], carry);
+            carry = _mm256_srli_epi64(v, Radix);
+            _mm256_storeu_si256((__m256i*)(r + j * Lanes), _mm256_and_si256(v, mask));
+        }
+    }
+};
+
+class BatchModExpEngine {
+public:
+    virtual ~BatchModExpEngine() = default;
+
+    // out[i] = xs[i]^e mod m for i < count
+    virtual void ExpMany(const CryptoPP::Integer* xs, size_t count, const CryptoPP::Integer& e,
+                         CryptoPP::Integer* out) const = 0;
+
+    // Kernel in use, for reports: "avx512-ifma", "avx2" or "scalar"
+    virtual const char* Name() const = 0;
+};
+
+// Fallback: the scalar engine, one operand at a time
+class ScalarBatchModExp : public BatchModExpEngine {
+public:
+    explicit ScalarBatchModExp(const CryptoPP::Integer& m) : engine(MakeModExpEngine(m)) {}
+
+    void ExpMany(const CryptoPP::Integer* xs, size_t count, const CryptoPP::Integer& e,
+                 CryptoPP::Integer* out) const override {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = engine->Exp(xs[i], e);
+        }
+    }
+
+    const char* Name() const override { return "scalar"; }
+
+private:
+    std::unique_ptr<ModExpEngine> engine;
+};
+
+// Multi-buffer engine for odd moduli of up to MaxBits bits
+template <class Kernel, unsigned MaxBits>
+class MultiBufferModExp : public BatchModExpEngine {
+public:
+    static const size_t Lanes = Kernel::Lanes;
+    static const unsigned Radix = Kernel::Radix;
+    static const size_t Digits = (MaxBits + 2 + Radix - 1) / Radix;  // R = 2^(Radix * Digits) > 4m
+    static const size_t Size = Digits * Lanes;
+
+    MultiBufferModExp(const CryptoPP::Integer& m, const char* name)
+        : modulus(m), name(name), n(Size), one(Size) {
+        // -m^-1 mod 2^Radix by Newton iteration, as in MontgomeryModExp
+        uint64_t m0 = (uint64_t)m.GetBit(0);
+        for (unsigned b = 1; b < 64; b++) m0 |= (uint64_t)m.GetBit(b) << b;
+        uint64_t inv = 1;
+        for (int k = 0; k < 6; k++) inv *= 2 - m0 * inv;
+        k0 = (0 - inv) & ((1ULL << Radix) - 1);
+
+        R = CryptoPP::Integer::Power2(Radix * Digits);
+        for (size_t lane = 0; lane < Lanes; lane++) {
+            IntegerToDigits(m, Radix, Digits, n.data() + lane, Lanes);
+            IntegerToDigits(R % m, Radix, Digits, one.data() + lane, Lanes);
+        }
+    }
+
+    void ExpMany(const CryptoPP::Integer* xs, size_t count, const CryptoPP::Integer& e,
+                 CryptoPP::Integer* out) const override {
+        for (size_t first = 0; first < count; first += Lanes) {
+            ExpGroup(xs + first, std::min(Lanes, count - first), e, out + first);
+        }
+    }
+
+    const char* Name() const override { return name; }
+
+private:
+    void MontMul(uint64_t* r, const uint64_t* a, const uint64_t* b) const {
+        Kernel::template MontMul<Digits>(r, a, b, n.data(), k0);
+    }
+
+    // Up to Lanes operands at once; unused lanes compute 0^e
+    void ExpGroup(const CryptoPP::Integer* xs, size_t count, const CryptoPP::Integer& e, CryptoPP::Integer* out) const {
+        const size_t bits = e.BitCount();
+        const unsigned w = WindowBits(bits);
+        std::vector<uint64_t> base(Size, 0), acc(Size), selected(Size), table((size_t)32 * Size);
+        for (size_t lane = 0; lane < count; lane++) {
+            // Into Montgomery form in the scalar domain: x * R mod m
+            IntegerToDigits((xs[lane] % modulus) * R % modulus, Radix, Digits, base.data() + lane, Lanes);
+        }
+
+        // table[k] = x^k in Montgomery form, k < 2^w, for every lane
+        std::copy(one.begin(), one.end(), table.begin());
+        for (size_t k = 1; k < (1u << w); k++) {
+            MontMul(&table[k * Size], &table[(k - 1) * Size], base.data());
+        }
+
+        // Same fixed windows and masked table scan as MontgomeryModExp::Exp; every lane uses
+        // the same digit, since the exponent is shared
+        std::copy(one.begin(), one.end(), acc.begin());
+        size_t windows = (bits + w - 1) / w;
+        for (size_t win = windows; win-- > 0;) {
+            for (unsigned s = 0; s < w; s++) {
+                MontMul(acc.data(), acc.data(), acc.data());
+            }
+            unsigned digit = 0;
+            for (unsigned b = w; b-- > 0;) {
+                digit = (digit << 1) | e.GetBit(win * w + b);
+            }
+            std::fill(selected.begin(), selected.end(), 0);
+            for (size_t k = 0; k < (1u << w); k++) {
+                uint64_t mask = -(uint64_t)(k == digit);
+                for (size_t j = 0; j < Size; j++) {
+                    selected[j] |= table[k * Size + j] & mask;
+                }
+            }
+            MontMul(acc.data(), acc.data(), selected.data());
+        }
+
+        // Out of Montgomery form (multiply by 1); the result is at most m, so one
+        // comparison finishes the reduction
+        std::vector<uint64_t> unit(Size, 0);
+        std::fill(unit.begin(), unit.begin() + Lanes, 1);
+        MontMul(acc.data(), acc.data(), unit.data());
+        for (size_t lane = 0; lane < count; lane++) {
+            CryptoPP::Integer x = DigitsToInteger(acc.data() + lane, Lanes, Radix, Digits);
+            out[lane] = x >= modulus ? x - modulus : x;
+        }
+    }
+
+    CryptoPP::Integer modulus, R;
+    const char* name;
+    std::vector<uint64_t> n, one;  // digit-major, the same value in every lane
+    uint64_t k0;
+};
+
+// Function to build the batch engine for modulus m: the widest kernel this CPU supports
+// (AVX-512 IFMA, then AVX2) in the smallest size class that holds m, or the scalar fallback
+inline std::unique_ptr<BatchModExpEngine> MakeBatchModExpEngine(const CryptoPP::Integer& m) {
+    const unsigned bits = m.BitCount();
+    if (m.IsOdd() && bits <= 2048) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma")) {
+            const char* name = "avx512-ifma";
+            if (bits <= 1024) return std::unique_ptr<BatchModExpEngine>(new MultiBufferModExp<IfmaKernel, 1024>(m, name));
+            if (bits <= 1536) return std::unique_ptr<BatchModExpEngine>(new MultiBufferModExp<IfmaKernel, 1536>(m, name));
+            return std::unique_ptr<BatchModExpEngine>(new MultiBufferModExp<IfmaKernel, 2048>(m, name));
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            const char* name = "avx2";
+            if (bits <= 1024) return std::unique_ptr<BatchModExpEngine>(new MultiBufferModExp<Avx2Kernel, 1024>(m, name));
+            if (bits <= 1536) return std::unique_ptr<BatchModExpEngine>(new MultiBufferModExp<Avx2Kernel, 1536>(m, name));
+            return std::unique_ptr<BatchModExpEngine>(new MultiBufferModExp<Avx2Kernel, 2048>(m, name));
+        }
+    }
+    return std::unique_ptr<BatchModExpEngine>(new ScalarBatchModExp(m));
+}
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef MONTEXP_H
+#define MONTEXP_H
+
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/integer.h>
+#include <cryptopp/nbtheory.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+// Modular exponentiation engine for RSA-sized odd moduli. A context is built once per modulus
+// (limbs of n, -n^-1 mod 2^64, R mod n and R^2 mod n with R = 2^(64 * Limbs)) and can then be
+// used for any number of exponentiations, from several threads at once (Exp only touches the
+// stack). Limbs is a compile-time constant, so the Montgomery loops have fixed trip counts and
+// unroll (completely up to 1024-bit moduli, by 16 above that, which keeps compile times short).
+// Instances cover 512- to 4096-bit moduli and so the CRT halves of 1024- to 8192-bit keys.
+
+typedef unsigned __int128 uint128_t;
+
+// Function to turn x (0 <= x < 2^(64 * limbs)) into little-endian 64-bit limbs
+inline void IntegerToLimbs(const CryptoPP::Integer& x, uint64_t* limbs, size_t count) {
+    std::vector<CryptoPP::byte> bytes(8 * count);
+    x.Encode(bytes.data(), bytes.size());
+    for (size_t i = 0; i < count; i++) {
+        uint64_t limb = 0;
+        for (size_t b = 0; b < 8; b++) {
+            limb = (limb << 8) | bytes[8 * (count - 1 - i) + b];
+        }
+        limbs[i] = limb;
+    }
+}
+
+inline CryptoPP::Integer LimbsToInteger(const uint64_t* limbs, size_t count) {
+    std::vector<CryptoPP::byte> bytes(8 * count);
+    for (size_t i = 0; i < count; i++) {
+        for (size_t b = 0; b < 8; b++) {
+            bytes[8 * (count - 1 - i) + b] = (CryptoPP::byte)(limbs[i] >> (56 - 8 * b));
+        }
+    }
+    return CryptoPP::Integer(bytes.data(), bytes.size());
+}
+
+// Window size for an exponent of the given length: small public exponents such as 65537 use
+// plain square-and-multiply, full-size private exponents a 5-bit window (32-entry table)
+inline unsigned WindowBits(size_t exponentBits) {
+    return exponentBits <= 32 ? 1 : exponentBits <= 128 ? 3 : exponentBits <= 512 ? 4 : 5;
+}
+
+class ModExpEngine {
+public:
+    virtual ~ModExpEngine() = default;
+
+    // x^e mod m for x >= 0, e >= 0
+    virtual CryptoPP::Integer Exp(const CryptoPP::Integer& x, const CryptoPP::Integer& e) const = 0;
+
+    const CryptoPP::Integer& Modulus() const { return modulus; }
+
+protected:
+    explicit ModExpEngine(const CryptoPP::Integer& m) : modulus(m) {}
+    CryptoPP::Integer modulus;
+};
+
+// Fallback for moduli the Montgomery engine does not cover (even, or over 4096 bits)
+class GenericModExp : public ModExpEngine {
+public:
+    explicit GenericModExp(const CryptoPP::Integer& m) : ModExpEngine(m) {}
+
+    CryptoPP::Integer Exp(const CryptoPP::Integer& x, const CryptoPP::Integer& e) const override {
+        return CryptoPP::a_exp_b_mod_c(x, e, modulus);
+    }
+};
+
+template <size_t Limbs>
+class MontgomeryModExp : public ModExpEngine {
+public:
+    explicit MontgomeryModExp(const CryptoPP::Integer& m) : ModExpEngine(m) {
+        IntegerToLimbs(m, n, Limbs);
+        // -n^-1 mod 2^64 by Newton iteration: each step doubles the number of correct bits
+        uint64_t inv = 1;
+        for (int k = 0; k < 6; k++) {
+            inv *= 2 - n[0] * inv;
+        }
+        n0 = -inv;
+        CryptoPP::Integer R = CryptoPP::Integer::Power2(64 * Limbs);
+        IntegerToLimbs(R % m, one, Limbs);
+        IntegerToLimbs((R * R) % m, rr, Limbs);
+    }
+
+    // Montgomery product r = a * b / R mod n (r < n), in product-scanning form: column k of the
+    // double-width result collects every a[j] * b[k - j] and q[j] * n[k - j] in a three-limb
+    // accumulator, where q[k] is chosen so that column k < Limbs ends in zero (the division by
+    // R is then just dropping those columns). The multiplication and the reduction are fused
+    // into one pass, and the accumulator stays in registers. r may alias a or b.
+    void MontMul(uint64_t* r, const uint64_t* a, const uint64_t* b) const {
+        uint64_t t[Limbs + 1], q[Limbs];
+        uint64_t c0 = 0, c1 = 0, c2 = 0;
+#pragma GCC unroll 16
+        for (size_t k = 0; k < Limbs; k++) {
+#pragma GCC unroll 16
+            for (size_t j = 0; j < k; j++) {
+                MulAdd(c0, c1, c2, a[j], b[k - j]);
+                MulAdd(c0, c1, c2, q[j], n[k - j]);
+            }
+            MulAdd(c0, c1, c2, a[k], b[0]);
+            q[k] = c0 * n0;
+            MulAdd(c0, c1, c2, q[k], n[0]);
+            c0 = c1, c1 = c2, c2 = 0;
+        }
+#pragma GCC unroll 16
+        for (size_t k = Limbs; k < 2 * Limbs - 1; k++) {
+#pragma GCC unroll 16
+            for (size_t j = k - Limbs + 1; j < Limbs; j++) {
+                MulAdd(c0, c1, c2, a[j], b[k - j]);
+                MulAdd(c0, c1, c2, q[j], n[k - j]);
+            }
+            t[k - Limbs] = c0;
+            c0 = c1, c1 = c2, c2 = 0;
+        }
+        t[Limbs - 1] = c0;
+        t[Limbs] = c1;
+        FinalSubtract(r, t);
+    }
+
+    // Montgomery square r = a * a / R mod n: the same columns, but each cross product
+    // a[j] * a[k - j] (j < k - j) is computed once and doubled, which saves close to half of the
+    // multiplications of the product part. Squarings are most of an exponentiation.
+    void MontSqr(uint64_t* r, const uint64_t* a) const {
+        uint64_t t[Limbs + 1], q[Limbs];
+        uint64_t c0 = 0, c1 = 0, c2 = 0;
+#pragma GCC unroll 16
+        for (size_t k = 0; k < Limbs; k++) {
+            SquareColumn(c0, c1, c2, a, k, 0);
+#pragma GCC unroll 16
+            for (size_t j = 0; j < k; j++) {
+                MulAdd(c0, c1, c2, q[j], n[k - j]);
+            }
+            q[k] = c0 * n0;
+            MulAdd(c0, c1, c2, q[k], n[0]);
+            c0 = c1, c1 = c2, c2 = 0;
+        }
+#pragma GCC unroll 16
+        for (size_t k = Limbs; k < 2 * Limbs - 1; k++) {
+            SquareColumn(c0, c1, c2, a, k, k - Limbs + 1);
+#pragma GCC unroll 16
+            for (size_t j = k - Limbs + 1; j < Limbs; j++) {
+                MulAdd(c0, c1, c2, q[j], n[k - j]);
+            }
+            t[k - Limbs] = c0;
+            c0 = c1, c1 = c2, c2 = 0;
+        }
+        t[Limbs - 1] = c0;
+        t[Limbs] = c1;
+        FinalSubtract(r, t);
+    }
+
+    CryptoPP::Integer Exp(const CryptoPP::Integer& x, const CryptoPP::Integer& e) const override {
+        const size_t bits = e.BitCount();
+        const unsigned w = WindowBits(bits);
+        uint64_t base[Limbs], acc[Limbs];
+        IntegerToLimbs(x % modulus, base, Limbs);
+        MontMul(base, base, rr);  // into Montgomery form
+
+        // table[k] = x^k in Montgomery form, k < 2^w
+        uint64_t table[32][Limbs];
+        std::copy(one, one + Limbs, table[0]);
+        for (size_t k = 1; k < (1u << w); k++) {
+            MontMul(table[k], table[k - 1], base);
+        }
+
+        // Fixed windows from the top; the table entry is read with a full masked scan so the
+        // memory access pattern does not depend on the (secret) exponent digits
+        std::copy(one, one + Limbs, acc);
+        size_t windows = (bits + w - 1) / w;
+        for (size_t win = windows; win-- > 0;) {
+            for (unsigned s = 0; s < w; s++) {
+                MontSqr(acc, acc);
+            }
+            unsigned digit = 0;
+            for (unsigned b = w; b-- > 0;) {
+                digit = (digit << 1) | e.GetBit(win * w + b);
+            }
+            uint64_t selected[Limbs] = {};
+            for (size_t k = 0; k < (1u << w); k++) {
+                uint64_t mask = -(uint64_t)(k == digit);
+                for (size_t j = 0; j < Limbs; j++) {
+                    selected[j] |= table[k][j] & mask;
+                }
+            }
+            MontMul(acc, acc, selected);
+        }
+
+        // Out of Montgomery form: multiply by 1
+        uint64_t unit[Limbs] = {1};
+        MontMul(acc, acc, unit);
+        return LimbsToInteger(acc, Limbs);
+    }
+
+private:
+    // (c2:c1:c0) += x * y
+    static void MulAdd(uint64_t& c0, uint64_t& c1, uint64_t& c2, uint64_t x, uint64_t y) {
+        uint128_t p = (uint128_t)x * y;
+        uint128_t low = ((uint128_t)c1 << 64 | c0) + p;
+        c2 += low < p;
+        c0 = (uint64_t)low;
+        c1 = (uint64_t)(low >> 64);
+    }
+
+    // (c2:c1:c0) += column k of a * a, whose products a[j] * a[k - j] start at j = low
+    static void SquareColumn(uint64_t& c0, uint64_t& c1, uint64_t& c2, const uint64_t* a, size_t k, size_t low) {
+        uint64_t d0 = 0, d1 = 0, d2 = 0;
+#pragma GCC unroll 16
+        for (size_t j = low; 2 * j < k; j++) {
+            MulAdd(d0, d1, d2, a[j], a[k - j]);
+        }
+        uint128_t d = (uint128_t)(d1 << 1 | d0 >> 63) << 64 | d0 << 1;
+        uint128_t sum = ((uint128_t)c1 << 64 | c0) + d;
+        c2 += (d2 << 1 | d1 >> 63) + (sum < d);
+        c0 = (uint64_t)sum;
+        c1 = (uint64_t)(sum >> 64);
+        if (k % 2 == 0) {
+            MulAdd(c0, c1, c2, a[k / 2], a[k / 2]);
+        }
+    }
+
+    // r = t - n if that does not borrow, else t (t < 2n, so one subtraction is enough); the
+    // choice is made with a mask instead of a branch
+    void FinalSubtract(uint64_t* r, const uint64_t* t) const {
+        uint64_t d[Limbs];
+        uint64_t borrow = 0;
+        for (size_t j = 0; j < Limbs; j++) {
+            uint128_t s = (uint128_t)t[j] - n[j] - borrow;
+            d[j] = (uint64_t)s;
+            borrow = (uint64_t)(s >> 64) & 1;
+        }
+        uint64_t keep = -(uint64_t)(borrow & (t[Limbs] ^ 1));
+        for (size_t j = 0; j < Limbs; j++) {
+            r[j] = (t[j] & keep) | (d[j] & ~keep);
+        }
+    }
+
+    uint64_t n[Limbs], one[Limbs], rr[Limbs];
+    uint64_t n0;
+};
+
+// Function to build the engine for modulus m: the smallest compiled limb count that holds it,
+// or the generic fallback
+inline std::unique_ptr<ModExpEngine> MakeModExpEngine(const CryptoPP::Integer& m) {
+    if (m.IsOdd()) {
+        size_t limbs = (m.BitCount() + 63) / 64;
+        if (limbs <= 8) return std::unique_ptr<ModExpEngine>(new MontgomeryModExp<8>(m));
+        if (limbs <= 16) return std::unique_ptr<ModExpEngine>(new MontgomeryModExp<16>(m));
+        if (limbs <= 24) return std::unique_ptr<ModExpEngine>(new MontgomeryModExp<24>(m));
+        if (limbs <= 32) return std::unique_ptr<ModExpEngine>(new MontgomeryModExp<32>(m));
+        if (limbs <= 48) return std::unique_ptr<ModExpEngine>(new MontgomeryModExp<48>(m));
+        if (limbs <= 64) return std::unique_ptr<ModExpEngine>(new MontgomeryModExp<64>(m));
+    }
+    return std::unique_ptr<ModExpEngine>(new GenericModExp(m));
+}
+
+// Function to compute x^e mod m once; tools doing many operations with one modulus should keep
+// the engine from MakeModExpEngine instead
+inline CryptoPP::Integer ModExp(const CryptoPP::Integer& x, const CryptoPP::Integer& e, const CryptoPP::Integer& m) {
+    return MakeModExpEngine(m)->Exp(x, e);
+}
+
+#endif
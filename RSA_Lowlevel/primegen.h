@@ -0,0 +1,149 @@
+#ifndef PRIMEGEN_H
+#define PRIMEGEN_H
+
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/integer.h>
+#include <cryptopp/osrng.h>
+#include <cryptopp/nbtheory.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <functional>
+
+// Parallel random prime search for RSA key generation. Every thread starts at its own random
+// point and walks a wheel of candidates: odd numbers for plain primes, numbers = 11 mod 12 for
+// safe primes p = 2q + 1 (so neither p nor q is divisible by 2 or 3). Each window of
+// SIEVE_WINDOW candidates is sieved by all odd primes below SIEVE_LIMIT. The residues of the
+// window start are computed once and then advanced incrementally from window to window. Only
+// the survivors get Miller-Rabin tests, and the first thread to find a prime stops the others.
+
+const unsigned SIEVE_LIMIT = 1 << 16;
+const unsigned SIEVE_WINDOW = 4096;
+
+// Function to list the odd primes below limit with a sieve of Eratosthenes
+inline std::vector<unsigned> SmallOddPrimes(unsigned limit) {
+    std::vector<bool> composite(limit, false);
+    std::vector<unsigned> primes;
+    for (unsigned x = 3; x < limit; x += 2) {
+        if (composite[x]) continue;
+        primes.push_back(x);
+        for (unsigned long long y = (unsigned long long)x * x; y < limit; y += 2 * x) {
+            composite[y] = true;
+        }
+    }
+    return primes;
+}
+
+// Miller-Rabin rounds for a random candidate of the given size (FIPS 186-4, Table C.3)
+inline unsigned MillerRabinRounds(unsigned bits) {
+    return bits >= 1536 ? 4 : bits >= 1024 ? 5 : bits >= 512 ? 8 : 40;
+}
+
+struct PrimeSearch {
+    unsigned bits;
+    bool safe;
+    std::vector<unsigned> primes;     // sieving primes (5 and up in safe mode, 3 and up otherwise)
+    std::vector<unsigned> stepInv;    // step^-1 mod prime
+    std::vector<unsigned> windowStep; // SIEVE_WINDOW * step mod prime
+    std::atomic<bool> found{false};
+    std::mutex resultLock;
+    CryptoPP::Integer result;
+};
+
+// Function run by each search thread until some thread has found a prime
+inline void PrimeSearchWorker(PrimeSearch& search) {
+    CryptoPP::AutoSeededRandomPool rng;  // one generator per thread; the pool is not thread-safe
+    const unsigned step = search.safe ? 12 : 2;
+    const unsigned rounds = MillerRabinRounds(search.bits);
+    const size_t count = search.primes.size();
+    std::vector<unsigned> residues(count);
+    std::vector<bool> composite(SIEVE_WINDOW);
+
+    CryptoPP::Integer base;
+    bool restart = true;
+    while (!search.found) {
+        if (restart) {
+            // Random start with the top two bits set, so a product of two such primes has exactly 2 * bits bits
+            base.Randomize(rng, search.bits);
+            base.SetBit(search.bits - 1);
+            base.SetBit(search.bits - 2);
+            base += CryptoPP::Integer((long)((search.safe ? 11 : 1) + step - base.Modulo(step)));
+            for (size_t s = 0; s < count; s++) {
+                residues[s] = base.Modulo(search.primes[s]);
+            }
+            restart = false;
+        }
+        if ((base + CryptoPP::Integer((long)(SIEVE_WINDOW * step))).BitCount() > search.bits) {
+            restart = true;
+            continue;
+        }
+
+        // Mark candidates base + k * step divisible by a small prime (and, for safe primes,
+        // those = 1 mod the prime, where q = (p - 1) / 2 is divisible by it)
+        std::fill(composite.begin(), composite.end(), false);
+        for (size_t s = 0; s < count; s++) {
+            unsigned prime = search.primes[s];
+            unsigned long long r = residues[s];
+            unsigned first = (prime - r) % prime * search.stepInv[s] % prime;
+            for (unsigned k = first; k < SIEVE_WINDOW; k += prime) composite[k] = true;
+            if (search.safe) {
+                first = (prime + 1 - r) % prime * search.stepInv[s] % prime;
+                for (unsigned k = first; k < SIEVE_WINDOW; k += prime) composite[k] = true;
+            }
+            residues[s] = (r + search.windowStep[s]) % prime;
+        }
+
+        for (unsigned k = 0; k < SIEVE_WINDOW && !search.found; k++) {
+            if (composite[k]) continue;
+            CryptoPP::Integer candidate = base + CryptoPP::Integer((long)(k * step));
+            bool prime;
+            if (search.safe) {
+                // Cheap base-2 tests on both q and p first, the full rounds only when both pass
+                CryptoPP::Integer q = candidate >> 1;
+                prime = CryptoPP::IsStrongProbablePrime(q, 2) && CryptoPP::IsStrongProbablePrime(candidate, 2) &&
+                        CryptoPP::RabinMillerTest(rng, q, rounds) && CryptoPP::RabinMillerTest(rng, candidate, rounds);
+            } else {
+                prime = CryptoPP::IsStrongProbablePrime(candidate, 2) && CryptoPP::RabinMillerTest(rng, candidate, rounds);
+            }
+            if (prime) {
+                std::lock_guard<std::mutex> lock(search.resultLock);
+                if (!search.found) {
+                    search.result = candidate;
+                    search.found = true;
+                }
+            }
+        }
+        base += CryptoPP::Integer((long)(SIEVE_WINDOW * step));
+    }
+}
+
+// Function to generate a random prime of exactly bits bits (top two bits set) on threads threads
+// (0 = one per core). With safe = true the prime also has (p - 1) / 2 prime.
+inline CryptoPP::Integer GeneratePrime(unsigned bits, bool safe, unsigned threads = 0) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    PrimeSearch search;
+    search.bits = bits;
+    search.safe = safe;
+    unsigned step = safe ? 12 : 2;
+    for (unsigned prime : SmallOddPrimes(SIEVE_LIMIT)) {
+        if (safe && prime == 3) continue;  // already excluded by the wheel
+        search.primes.push_back(prime);
+        search.stepInv.push_back(CryptoPP::Integer((long)step).InverseMod(CryptoPP::Integer((long)prime)).ConvertToLong());
+        search.windowStep.push_back((unsigned long long)SIEVE_WINDOW * step % prime);
+    }
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back(PrimeSearchWorker, std::ref(search));
+    }
+    for (std::thread& t : pool) {
+        t.join();
+    }
+    return search.result;
+}
+
+#endif
@@ -0,0 +1,241 @@
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/integer.h>
+#include <cryptopp/osrng.h>
+#include <cryptopp/nbtheory.h>
+#include <cryptopp/sha.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include "rsakeygen.h"
+#include "batchrsa.h"
+#include "argparse.h"
+
+using namespace CryptoPP;
+
+// In-process latency benchmark: runs the operations of keygen, encrypt, decrypt, sign and
+// verify (without their file I/O) for several modulus sizes and reports the wall-clock latency
+// distribution of each, measured with steady_clock, after a few untimed warm-up runs. Two more
+// rows compare a full-width x^d mod n through Crypto++'s a_exp_b_mod_c ("exp-ref") with the
+// Montgomery engine of montexp.h, built once for n ("exp-mont"), and "dec-batch" decrypts
+// --batch-size ciphertexts at a time through the multi-buffer engines of montbatch.h (latency
+// per message). "dec-par" and "sign-par" are decrypt and sign with the CRT halves on two cores
+// (the --parallel-crt option of the tools). "fiat-b" decrypts b ciphertexts under b distinct
+// small exponents sharing n with batch RSA (batchrsa.h, decrypt --fiat), also per message; the
+// effective decrypts/sec by batch size are printed after each key's rows.
+
+struct LatencyStats {
+    unsigned bits;
+    std::string operation;
+    size_t iterations;
+    double mean, p50, p90, p99, max;  // ms
+};
+
+// Function to run op warmup times untimed, then iterations times timed, and summarize the latencies;
+// an op that handles opsPerCall messages is reported per message
+LatencyStats Measure(unsigned bits, const std::string& operation, size_t warmup, size_t iterations,
+                     const std::function<void()>& op, size_t opsPerCall = 1) {
+    for (size_t i = 0; i < warmup; i++) {
+        op();
+    }
+    std::vector<double> latencies;
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        op();
+        latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                            opsPerCall);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies[(size_t)(p * (latencies.size() - 1))]; };
+    double sum = 0;
+    for (double l : latencies) sum += l;
+    return {bits, operation, iterations, sum / iterations, percentile(0.5), percentile(0.9), percentile(0.99),
+            latencies.back()};
+}
+
+// Function to hash a message with SHA-256 into an Integer, as sign and verify do
+Integer HashMessage(const std::string& message) {
+    byte hash[SHA256::DIGESTSIZE];
+    SHA256().CalculateDigest(hash, (const byte*)message.data(), message.size());
+    return Integer(hash, sizeof(hash));
+}
+
+void WriteCsv(const std::string& filename, const std::vector<LatencyStats>& results) {
+    std::ofstream file(filename);
+    file << "bits,operation,iterations,mean_ms,p50_ms,p90_ms,p99_ms,max_ms\n";
+    for (const LatencyStats& r : results) {
+        file << r.bits << "," << r.operation << "," << r.iterations << "," << r.mean << "," << r.p50 << "," << r.p90
+             << "," << r.p99 << "," << r.max << "\n";
+    }
+}
+
+void WriteJson(const std::string& filename, const std::vector<LatencyStats>& results) {
+    std::ofstream file(filename);
+    file << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const LatencyStats& r = results[i];
+        file << "  {\"bits\": " << r.bits << ", \"operation\": \"" << r.operation << "\", \"iterations\": "
+             << r.iterations << ", \"mean_ms\": " << r.mean << ", \"p50_ms\": " << r.p50 << ", \"p90_ms\": " << r.p90
+             << ", \"p99_ms\": " << r.p99 << ", \"max_ms\": " << r.max << "}" << (i + 1 < results.size() ? "," : "")
+             << "\n";
+    }
+    file << "]\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<unsigned> sizes = {1024, 2048, 3072, 4096};
+    size_t iterations = 100, keygenIterations = 5, warmup = 5, batchSize = 64;
+    KeyGenOptions options;
+    std::string csvFile, jsonFile;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        bool parsed = true;
+        if (arg == "--bits" && a + 1 < argc) {
+            // comma-separated list, e.g. 2048,4096
+            sizes.clear();
+            std::stringstream list(argv[++a]);
+            std::string item;
+            unsigned bits;
+            while (parsed && std::getline(list, item, ',')) {
+                parsed = ParseUnsigned(item, bits);
+                sizes.push_back(bits);
+            }
+        } else if (arg == "--iterations" && a + 1 < argc) {
+            parsed = ParseUnsigned(argv[++a], iterations);
+        } else if (arg == "--keygen-iterations" && a + 1 < argc) {
+            parsed = ParseUnsigned(argv[++a], keygenIterations);
+        } else if (arg == "--warmup" && a + 1 < argc) {
+            parsed = ParseUnsigned(argv[++a], warmup);
+        } else if (arg == "--batch-size" && a + 1 < argc) {
+            parsed = ParseUnsigned(argv[++a], batchSize);
+        } else if (arg == "--small-e") {
+            options.publicExponent = DEFAULT_SMALL_E;
+        } else if (arg == "--primes" && a + 1 < argc) {
+            parsed = ParseUnsigned(argv[++a], options.primes);
+        } else if (arg == "--csv" && a + 1 < argc) {
+            csvFile = argv[++a];
+        } else if (arg == "--json" && a + 1 < argc) {
+            jsonFile = argv[++a];
+        } else {
+            parsed = false;
+        }
+        if (!parsed) {
+            std::cerr << "Usage: ./rsa_bench [--bits 1024,2048,3072,4096] [--iterations n] [--keygen-iterations n]\n"
+                      << "                   [--warmup n] [--batch-size n] [--small-e] [--primes k] [--csv <file>]\n"
+                      << "                   [--json <file>]\n";
+            return 1;
+        }
+    }
+    if (iterations == 0 || keygenIterations == 0 || batchSize == 0) {
+        std::cerr << "Need at least one timed iteration and message per batch\n";
+        return 1;
+    }
+    for (unsigned bits : sizes) {
+        if (options.primes < 2 || options.primes > 4 || bits / options.primes < 512) {
+            std::cerr << "Use 2 to 4 primes of at least 512 bits each\n";
+            return 1;
+        }
+    }
+
+    AutoSeededRandomPool rng;
+    std::vector<LatencyStats> results;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Latency in ms (wall clock), " << warmup << " warm-up runs per operation (at most 1 for keygen)"
+              << std::endl;
+    std::cout << "Multi-buffer kernel: " << MakeBatchModExpEngine(Integer::Power2(1023) + Integer::One())->Name()
+              << std::endl;
+    std::cout << std::setw(5) << "bits" << std::setw(10) << "op" << std::setw(7) << "n" << std::setw(11) << "mean"
+              << std::setw(11) << "p50" << std::setw(11) << "p90" << std::setw(11) << "p99" << std::setw(11) << "max"
+              << std::endl;
+
+    for (unsigned bits : sizes) {
+        options.modulusBits = bits;
+        RsaKeyPair keys;
+        std::vector<LatencyStats> rows;
+        rows.push_back(Measure(bits, "keygen", std::min<size_t>(warmup, 1), keygenIterations,
+                               [&] { keys = GenerateKeyPair(options); }));
+        const Integer& e = keys.e;
+        const Integer& n = keys.priv.n;
+
+        // Random message one byte shorter than the modulus, like a full block of encrypt --blocks
+        std::vector<byte> block(n.ByteCount() - 1);
+        rng.GenerateBlock(block.data(), block.size());
+        Integer m(block.data(), block.size());
+        std::string message(block.begin(), block.begin() + std::min<size_t>(block.size(), 100));
+
+        Integer C, decrypted, signature;
+        bool valid = false;
+        rows.push_back(Measure(bits, "encrypt", warmup, iterations, [&] { C = ModExp(m, e, n); }));
+        rows.push_back(Measure(bits, "decrypt", warmup, iterations, [&] { decrypted = RsaPrivateOp(keys.priv, C); }));
+        rows.push_back(Measure(bits, "sign", warmup, iterations,
+                               [&] { signature = RsaPrivateOp(keys.priv, HashMessage(message)); }));
+        Integer decryptedParallel, signatureParallel;
+        rows.push_back(Measure(bits, "dec-par", warmup, iterations,
+                               [&] { decryptedParallel = RsaPrivateOp(keys.priv, C, true); }));
+        rows.push_back(Measure(bits, "sign-par", warmup, iterations,
+                               [&] { signatureParallel = RsaPrivateOp(keys.priv, HashMessage(message), true); }));
+        rows.push_back(Measure(bits, "verify", warmup, iterations,
+                               [&] { valid = ModExp(signature, e, n) == HashMessage(message); }));
+
+        std::unique_ptr<ModExpEngine> engine = MakeModExpEngine(n);
+        Integer reference, fast;
+        rows.push_back(Measure(bits, "exp-ref", warmup, iterations, [&] { reference = a_exp_b_mod_c(C, keys.priv.d, n); }));
+        rows.push_back(Measure(bits, "exp-mont", warmup, iterations, [&] { fast = engine->Exp(C, keys.priv.d); }));
+
+        // The same ciphertext batchSize times: each lane does the full work either way
+        RsaPrivateContext priv(keys.priv);
+        std::vector<Integer> ciphertexts(batchSize, C), batch;
+        rows.push_back(Measure(bits, "dec-batch", warmup, iterations, [&] { batch = priv.ApplyAll(ciphertexts); },
+                               batchSize));
+        // Batch RSA on the same key: the first 8 usable small exponents, one ciphertext under each
+        const size_t fiatSizes[] = {1, 2, 4, 8};
+        FiatBatchDecryptor fiat(keys.priv);
+        std::vector<Integer> fiatExponents = FiatExponents(KeyPhi(keys.priv), 8), fiatCiphertexts;
+        for (const Integer& fe : fiatExponents) {
+            fiatCiphertexts.push_back(engine->Exp(m, fe));
+        }
+        bool fiatValid = true;
+        std::vector<double> fiatRates;
+        for (size_t b : fiatSizes) {
+            std::vector<Integer> exps(fiatExponents.begin(), fiatExponents.begin() + b);
+            std::vector<Integer> cts(fiatCiphertexts.begin(), fiatCiphertexts.begin() + b), plain;
+            rows.push_back(Measure(bits, "fiat-" + std::to_string(b), warmup, iterations,
+                                   [&] { fiatValid &= fiat.Decrypt(exps, cts, plain); }, b));
+            fiatValid &= std::all_of(plain.begin(), plain.end(), [&](const Integer& p) { return p == m; });
+            fiatRates.push_back(1000 / rows.back().mean);
+        }
+        if (decrypted != m || !valid || reference != m || fast != m || batch.back() != m || decryptedParallel != m ||
+            signatureParallel != signature || !fiatValid) {
+            std::cerr << "Round trip failed for the " << bits << "-bit key\n";
+            return 1;
+        }
+
+        for (const LatencyStats& r : rows) {
+            std::cout << std::setw(5) << r.bits << std::setw(10) << r.operation << std::setw(7) << r.iterations
+                      << std::setw(11) << r.mean << std::setw(11) << r.p50 << std::setw(11) << r.p90 << std::setw(11)
+                      << r.p99 << std::setw(11) << r.max << std::endl;
+            results.push_back(r);
+        }
+        std::cout << std::setw(5) << bits << "  batch RSA decrypts/s:" << std::setprecision(0);
+        for (size_t i = 0; i < fiatRates.size(); i++) {
+            std::cout << "  b=" << fiatSizes[i] << " " << fiatRates[i];
+        }
+        std::cout << std::setprecision(3) << std::endl;
+    }
+
+    if (!csvFile.empty()) {
+        WriteCsv(csvFile, results);
+        std::cout << "CSV written to " << csvFile << std::endl;
+    }
+    if (!jsonFile.empty()) {
+        WriteJson(jsonFile, results);
+        std::cout << "JSON written to " << jsonFile << std::endl;
+    }
+    return 0;
+}
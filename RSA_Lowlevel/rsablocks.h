@@ -0,0 +1,122 @@
+#ifndef RSABLOCKS_H
+#define RSABLOCKS_H
+
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/integer.h>
+#include <cryptopp/nbtheory.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include "rsakey.h"
+
+// Block stream written by encrypt --blocks and read by decrypt --blocks:
+//   "RSABLK1\0", modulus size k in bytes (4 bytes, big-endian)
+//   then per block: plaintext length L (4 bytes, big-endian, 1 <= L <= k - 1), ciphertext (k bytes)
+// Plaintext blocks hold k - 1 bytes, so every block is below n and nothing is lost to m % n.
+// L restores the leading zero bytes that the integer form of a block drops.
+
+const char BLOCK_MAGIC[8] = {'R', 'S', 'A', 'B', 'L', 'K', '1', '\0'};
+
+// Function to run work(0) .. work(count - 1) on threads threads (0 = one per core); each
+// thread takes the next index until none are left
+inline void ParallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& work) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < std::min<size_t>(threads, count); t++) {
+        pool.emplace_back([&] {
+            for (size_t i = next++; i < count; i = next++) {
+                work(i);
+            }
+        });
+    }
+    for (std::thread& t : pool) {
+        t.join();
+    }
+}
+
+inline void PutUint32(char* out, uint32_t value) {
+    for (int b = 0; b < 4; b++) {
+        out[b] = (char)(value >> (24 - 8 * b));
+    }
+}
+
+inline uint32_t GetUint32(const char* in) {
+    uint32_t value = 0;
+    for (int b = 0; b < 4; b++) {
+        value = (value << 8) | (uint8_t)in[b];
+    }
+    return value;
+}
+
+// Function to encrypt data of any length as a block stream, blocks in parallel
+inline std::string EncryptBlocks(const CryptoPP::Integer& e, const CryptoPP::Integer& n, const std::string& data,
+                                 unsigned threads = 0) {
+    size_t k = n.ByteCount();
+    size_t blockSize = k - 1;
+    size_t blocks = (data.size() + blockSize - 1) / blockSize;
+    size_t record = 4 + k;
+
+    size_t header = sizeof(BLOCK_MAGIC) + 4;
+    std::string out(header + blocks * record, '\0');
+    std::copy(BLOCK_MAGIC, BLOCK_MAGIC + sizeof(BLOCK_MAGIC), out.begin());
+    PutUint32(&out[sizeof(BLOCK_MAGIC)], k);
+
+    RsaPublicContext pub(e, n);
+    ParallelFor(blocks, threads, [&](size_t b) {
+        size_t length = std::min(blockSize, data.size() - b * blockSize);
+        CryptoPP::Integer m((const CryptoPP::byte*)data.data() + b * blockSize, length);
+        CryptoPP::Integer C = pub.Apply(m);
+
+        char* rec = &out[header + b * record];
+        PutUint32(rec, length);
+        C.Encode((CryptoPP::byte*)rec + 4, k);
+    });
+    return out;
+}
+
+// Function to decrypt a block stream, blocks in parallel; false if the stream is malformed
+// or was made for a different modulus
+inline bool DecryptBlocks(const RsaPrivateKey& key, const std::string& stream, std::string& plain,
+                          unsigned threads = 0) {
+    size_t k = key.n.ByteCount();
+    size_t header = sizeof(BLOCK_MAGIC) + 4;
+    size_t record = 4 + k;
+    if (stream.size() < header || stream.compare(0, sizeof(BLOCK_MAGIC), BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) != 0 ||
+        GetUint32(stream.data() + sizeof(BLOCK_MAGIC)) != k || (stream.size() - header) % record != 0) {
+        return false;
+    }
+    size_t blocks = (stream.size() - header) / record;
+
+    // Output offsets come from the length prefixes, so every block knows where it goes
+    std::vector<size_t> offset(blocks + 1, 0);
+    for (size_t b = 0; b < blocks; b++) {
+        uint32_t length = GetUint32(stream.data() + header + b * record);
+        if (length == 0 || length > k - 1) return false;
+        offset[b + 1] = offset[b] + length;
+    }
+    plain.assign(offset[blocks], '\0');
+
+    RsaPrivateContext priv(key);
+    std::atomic<bool> ok(true);
+    ParallelFor(blocks, threads, [&](size_t b) {
+        const char* rec = stream.data() + header + b * record;
+        CryptoPP::Integer C((const CryptoPP::byte*)rec + 4, k);
+        CryptoPP::Integer m = priv.Apply(C);
+        size_t length = offset[b + 1] - offset[b];
+        if (C >= key.n || m.MinEncodedSize() > length) {
+            ok = false;
+            return;
+        }
+        m.Encode((CryptoPP::byte*)&plain[offset[b]], length);
+    });
+    return ok;
+}
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef RSAKEY_H
+#define RSAKEY_H
+
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/integer.h>
+#include <cryptopp/nbtheory.h>
+#include <cryptopp/files.h>
+#include <string>
+#include <memory>
+#include <vector>
+#include <functional>
+#include "montexp.h"
+#include "montbatch.h"
+#include "threadpool.h"
+
+// Private key as stored in private_key.bin: DER-encoded (d, n), optionally followed by the
+// CRT fields (p, q, dP, dQ, qInv) and, for multi-prime keys, one (r, d_r, t) triple per
+// further prime as in PKCS #1 OtherPrimeInfo. Older tools only read the first two integers,
+// and files written before the CRT fields existed still load (hasCrt is then false). Tools
+// from before multi-prime keys see p * q != n and fall back to the full-width d.
+struct RsaPrimeInfo {
+    CryptoPP::Integer r;  // the prime
+    CryptoPP::Integer d;  // d mod (r - 1)
+    CryptoPP::Integer t;  // (product of the primes before r)^-1 mod r
+};
+
+struct RsaPrivateKey {
+    CryptoPP::Integer d, n;
+    CryptoPP::Integer p, q;
+    CryptoPP::Integer dP, dQ;  // d mod (p - 1), d mod (q - 1)
+    CryptoPP::Integer qInv;    // q^-1 mod p
+    std::vector<RsaPrimeInfo> otherPrimes;  // third and later primes of a multi-prime key
+    bool hasCrt = false;
+};
+
+// Function to fill in the CRT fields from d and the primes (two or more, p and q first)
+inline RsaPrivateKey MakePrivateKey(const CryptoPP::Integer& d, const std::vector<CryptoPP::Integer>& primes) {
+    RsaPrivateKey key;
+    key.d = d;
+    key.p = primes[0];
+    key.q = primes[1];
+    key.n = key.p * key.q;
+    key.dP = d % (key.p - 1);
+    key.dQ = d % (key.q - 1);
+    key.qInv = key.q.InverseMod(key.p);
+    for (size_t i = 2; i < primes.size(); i++) {
+        const CryptoPP::Integer& r = primes[i];
+        key.otherPrimes.push_back({r, d % (r - 1), key.n.InverseMod(r)});
+        key.n *= r;
+    }
+    key.hasCrt = true;
+    return key;
+}
+
+inline RsaPrivateKey MakePrivateKey(const CryptoPP::Integer& d, const CryptoPP::Integer& p, const CryptoPP::Integer& q) {
+    return MakePrivateKey(d, std::vector<CryptoPP::Integer>{p, q});
+}
+
+// Function to write a private key; the CRT fields are only written when present
+inline void SavePrivateKey(const std::string& privKeyFile, const RsaPrivateKey& key) {
+    CryptoPP::FileSink priv(privKeyFile.c_str());
+    key.d.DEREncode(priv);
+    key.n.DEREncode(priv);
+    if (key.hasCrt) {
+        key.p.DEREncode(priv);
+        key.q.DEREncode(priv);
+        key.dP.DEREncode(priv);
+        key.dQ.DEREncode(priv);
+        key.qInv.DEREncode(priv);
+        for (const RsaPrimeInfo& prime : key.otherPrimes) {
+            prime.r.DEREncode(priv);
+            prime.d.DEREncode(priv);
+            prime.t.DEREncode(priv);
+        }
+    }
+    priv.MessageEnd();
+}
+
+// Function to read a private key in the (d, n), (d, n, p, q, dP, dQ, qInv) or multi-prime format
+inline RsaPrivateKey LoadPrivateKey(const std::string& privKeyFile) {
+    RsaPrivateKey key;
+    CryptoPP::FileSource privFile(privKeyFile.c_str(), true);
+    key.d.BERDecode(privFile);
+    key.n.BERDecode(privFile);
+    if (privFile.AnyRetrievable()) {
+        key.p.BERDecode(privFile);
+        key.q.BERDecode(privFile);
+        key.dP.BERDecode(privFile);
+        key.dQ.BERDecode(privFile);
+        key.qInv.BERDecode(privFile);
+        CryptoPP::Integer product = key.p * key.q;
+        while (privFile.AnyRetrievable()) {
+            RsaPrimeInfo prime;
+            prime.r.BERDecode(privFile);
+            prime.d.BERDecode(privFile);
+            prime.t.BERDecode(privFile);
+            product *= prime.r;
+            key.otherPrimes.push_back(prime);
+        }
+        key.hasCrt = product == key.n;
+    }
+    return key;
+}
+
+// Number of primes of a CRT key, and prime i with its exponent (p, q, then the other primes)
+inline size_t CrtPrimeCount(const RsaPrivateKey& key) {
+    return 2 + key.otherPrimes.size();
+}
+
+inline const CryptoPP::Integer& CrtPrime(const RsaPrivateKey& key, size_t i) {
+    return i == 0 ? key.p : i == 1 ? key.q : key.otherPrimes[i - 2].r;
+}
+
+inline const CryptoPP::Integer& CrtExponent(const RsaPrivateKey& key, size_t i) {
+    return i == 0 ? key.dP : i == 1 ? key.dQ : key.otherPrimes[i - 2].d;
+}
+
+// Function to compute x^d mod n. With the CRT fields it does two half-size exponentiations
+// and recombines them with Garner's formula:
+//   m1 = x^dP mod p, m2 = x^dQ mod q, h = qInv * (m1 - m2) mod p, m = m2 + h * q
+// which is about 3-4x faster than the full-width x^d mod n.
+inline CryptoPP::Integer GarnerCombine(const RsaPrivateKey& key, const CryptoPP::Integer& m1, const CryptoPP::Integer& m2) {
+    CryptoPP::Integer h = (key.qInv * (m1 + key.p - m2 % key.p)) % key.p;
+    return m2 + h * key.q;
+}
+
+// Multi-prime keys (PKCS #1 RSADP step 2b) extend the result one prime at a time: with m
+// correct modulo R = p * q * r_3 ... r_(i-1), m_i = x^d_i mod r_i and h = (m_i - m) * t_i mod r_i,
+// m + R * h is correct modulo R * r_i. residues[i] is x^(exponent i) mod (prime i).
+inline CryptoPP::Integer CrtCombine(const RsaPrivateKey& key, const std::vector<CryptoPP::Integer>& residues) {
+    CryptoPP::Integer m = GarnerCombine(key, residues[0], residues[1]);
+    CryptoPP::Integer R = key.p * key.q;
+    for (size_t i = 0; i < key.otherPrimes.size(); i++) {
+        const RsaPrimeInfo& prime = key.otherPrimes[i];
+        CryptoPP::Integer h = ((residues[i + 2] + prime.r - m % prime.r) * prime.t) % prime.r;
+        m += R * h;
+        R *= prime.r;
+    }
+    return m;
+}
+
+// The residues are independent. With three or more primes they are always computed in
+// parallel on the CRT thread pool (threadpool.h), the calling thread doing one of them; each
+// exponentiation is then a third or a quarter of the modulus size. parallelCrt does the same
+// for the two halves of an ordinary key, which roughly halves the latency of a single
+// operation on an idle machine at the cost of a second core.
+inline CryptoPP::Integer RsaPrivateOp(const RsaPrivateKey& key, const CryptoPP::Integer& x, bool parallelCrt = false) {
+    if (!key.hasCrt) {
+        return ModExp(x, key.d, key.n);
+    }
+    std::vector<CryptoPP::Integer> residues(CrtPrimeCount(key));
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < residues.size(); i++) {
+        tasks.push_back([&, i] { residues[i] = ModExp(x % CrtPrime(key, i), CrtExponent(key, i), CrtPrime(key, i)); });
+    }
+    if (residues.size() > 2 || parallelCrt) {
+        CrtThreadPool().RunAll(tasks);
+    } else {
+        tasks[0]();
+        tasks[1]();
+    }
+    return CrtCombine(key, residues);
+}
+
+// The batch modes handle many messages with one key. RsaPrivateOp and ModExp set up an engine
+// for the modulus on every call; these keep the engines from key load on instead. Engines are
+// read-only after construction, so one context can be shared by several threads.
+
+// Public key (e, n) with its exponentiation engine
+struct RsaPublicContext {
+    CryptoPP::Integer e, n;
+    std::shared_ptr<const ModExpEngine> engine;
+
+    RsaPublicContext(const CryptoPP::Integer& e, const CryptoPP::Integer& n) : e(e), n(n), engine(MakeModExpEngine(n)) {}
+
+    CryptoPP::Integer Apply(const CryptoPP::Integer& x) const { return engine->Exp(x, e); }
+};
+
+// Function to read a public key (e, n) into a context
+inline RsaPublicContext LoadPublicContext(const std::string& pubKeyFile) {
+    CryptoPP::Integer e, n;
+    CryptoPP::FileSource pubFile(pubKeyFile.c_str(), true);
+    e.BERDecode(pubFile);
+    n.BERDecode(pubFile);
+    return RsaPublicContext(e, n);
+}
+
+// Private key with an engine per prime (a single one for n when the key has no CRT fields).
+// ApplyAll runs a whole batch through the multi-buffer engines of montbatch.h, 8 (AVX-512
+// IFMA) or 4 (AVX2) messages per vector operation.
+struct RsaPrivateContext {
+    RsaPrivateKey key;
+    std::vector<std::shared_ptr<const ModExpEngine>> engines;
+    std::vector<std::shared_ptr<const BatchModExpEngine>> batches;
+
+    explicit RsaPrivateContext(const RsaPrivateKey& key) : key(key) {
+        for (size_t i = 0; i < (key.hasCrt ? CrtPrimeCount(key) : 1); i++) {
+            const CryptoPP::Integer& modulus = key.hasCrt ? CrtPrime(key, i) : key.n;
+            engines.emplace_back(MakeModExpEngine(modulus));
+            batches.emplace_back(MakeBatchModExpEngine(modulus));
+        }
+    }
+
+    // Same result as RsaPrivateOp(key, x)
+    CryptoPP::Integer Apply(const CryptoPP::Integer& x) const {
+        if (!key.hasCrt) {
+            return engines[0]->Exp(x, key.d);
+        }
+        std::vector<CryptoPP::Integer> residues(engines.size());
+        for (size_t i = 0; i < engines.size(); i++) {
+            residues[i] = engines[i]->Exp(x, CrtExponent(key, i));
+        }
+        return CrtCombine(key, residues);
+    }
+
+    // Same results as Apply on each element
+    std::vector<CryptoPP::Integer> ApplyAll(const std::vector<CryptoPP::Integer>& xs) const {
+        std::vector<CryptoPP::Integer> out(xs.size());
+        if (!key.hasCrt) {
+            batches[0]->ExpMany(xs.data(), xs.size(), key.d, out.data());
+            return out;
+        }
+        std::vector<std::vector<CryptoPP::Integer>> residues(batches.size(), std::vector<CryptoPP::Integer>(xs.size()));
+        for (size_t i = 0; i < batches.size(); i++) {
+            batches[i]->ExpMany(xs.data(), xs.size(), CrtExponent(key, i), residues[i].data());
+        }
+        std::vector<CryptoPP::Integer> column(batches.size());
+        for (size_t j = 0; j < xs.size(); j++) {
+            for (size_t i = 0; i < batches.size(); i++) {
+                column[i] = residues[i][j];
+            }
+            out[j] = CrtCombine(key, column);
+        }
+        return out;
+    }
+
+    // Multi-buffer kernel in use, for reports
+    const char* BatchKernel() const { return batches[0]->Name(); }
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef RSAKEYGEN_H
+#define RSAKEYGEN_H
+
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/integer.h>
+#include <cryptopp/osrng.h>
+#include <cryptopp/nbtheory.h>
+#include <vector>
+#include "rsakey.h"
+#include "primegen.h"
+#include "batchrsa.h"
+
+// Small public exponent used by --small-e when none is given
+const long DEFAULT_SMALL_E = 65537;
+
+struct KeyGenOptions {
+    // 0 picks a random d and derives a full-size e = d^-1 mod phi(n). A small odd exponent
+    // (e.g. 65537) is used as e and d is derived from it instead, which makes encrypt and
+    // verify about 100x cheaper; the private-key side is unchanged.
+    CryptoPP::Integer publicExponent = CryptoPP::Integer::Zero();
+    unsigned modulusBits = 2048;
+    bool safePrimes = false;  // p = 2p' + 1 with p' prime; not needed for RSA and much slower to find
+    unsigned threads = 0;     // prime search threads, 0 = one per core
+    unsigned primes = 2;      // 3 or 4 give a multi-prime key: smaller CRT exponentiations
+    // > 0 makes that many public keys sharing n for batch RSA (batchrsa.h), with the small prime
+    // exponents of FiatExponents; e is the first of them and d its inverse
+    unsigned batchExponents = 0;
+};
+
+struct RsaKeyPair {
+    CryptoPP::Integer e;  // public key is (e, priv.n)
+    RsaPrivateKey priv;
+    std::vector<CryptoPP::Integer> batchExponents;  // e_2 .. e_b for batch RSA, sharing priv.n
+};
+
+// Function to generate a key pair; used by keygen and, in-process, by rsa_bench
+inline RsaKeyPair GenerateKeyPair(const KeyGenOptions& options) {
+    CryptoPP::AutoSeededRandomPool rng;  //class provided by the Crypto++ library that is responsible for generating cryptographically secure random numbers.
+
+    // Generate the primes, each about modulusBits / primes bits (two halves for an ordinary
+    // key). The search is sieved and runs on all cores (primegen.h); safePrimes asks for safe
+    // primes as PrimeAndGenerator did.
+    const CryptoPP::Integer& publicExponent = options.publicExponent;
+    const unsigned k = options.primes;
+    std::vector<CryptoPP::Integer> primes(k);
+    CryptoPP::Integer n, phi_n;
+    // The primes must differ, a fixed e must be coprime to every r - 1 or it has no inverse, and
+    // with more than two primes (top two bits set each) the product can come out one bit short
+    bool retry;
+    do {
+        n = phi_n = CryptoPP::Integer::One();
+        retry = false;
+        for (unsigned i = 0; i < k; i++) {
+            primes[i] = GeneratePrime(options.modulusBits / k + (i < options.modulusBits % k), options.safePrimes,
+                                      options.threads);
+            for (unsigned j = 0; j < i; j++) retry |= primes[i] == primes[j];
+            // Compute n = r_1 * ... * r_k and phi(n) = (r_1 - 1) ... (r_k - 1)
+            n *= primes[i];
+            phi_n *= primes[i] - 1;
+        }
+    } while (retry || n.BitCount() != options.modulusBits ||
+             (!publicExponent.IsZero() && !CryptoPP::RelativelyPrime(publicExponent, phi_n)));
+
+    CryptoPP::Integer d, e;
+    std::vector<CryptoPP::Integer> batchExponents;
+    if (options.batchExponents > 0) {
+        // Batch RSA: the exponents skip primes that divide phi(n), so no retry is needed
+        batchExponents = FiatExponents(phi_n, options.batchExponents);
+        e = batchExponents.front();
+        d = e.InverseMod(phi_n);
+        batchExponents.erase(batchExponents.begin());
+    } else if (publicExponent.IsZero()) {
+        // Choose d such that 1 < d < phi_n and gcd(d, phi_n) = 1
+        do {
+            d.Randomize(rng, CryptoPP::Integer::One(), phi_n - 1);
+        } while (!CryptoPP::RelativelyPrime(d, phi_n));
+
+        // Calculate public key e
+        e = d.InverseMod(phi_n);
+    } else {
+        // Fixed small e; calculate private key d = e^-1 mod phi_n
+        e = publicExponent;
+        d = e.InverseMod(phi_n);
+    }
+    return {e, MakePrivateKey(d, primes), batchExponents};
+}
+
+#endif
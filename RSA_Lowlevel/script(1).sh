@@ -23,7 +23,7 @@ for (( i=1; i<=ITERATIONS; i++ ))
 
 
             echo "Compiling sign.cpp..."
-            g++ sign.cpp -o sign -lcryptopp
+            g++ -O2 sign.cpp -o sign -lcryptopp -pthread
 
             # Check if the compilation was successful
             if [ $? -eq 0 ]; then
@@ -46,7 +46,7 @@ for (( i=1; i<=ITERATIONS; i++ ))
 
                     # Compile the verify.cpp file
                     echo "Compiling verify.cpp..."
-                    g++ verify.cpp -o verify -lcryptopp
+                    g++ -O2 verify.cpp -o verify -lcryptopp -pthread
 
                     # Check if the compilation was successful
                     if [ $? -eq 0 ]; then
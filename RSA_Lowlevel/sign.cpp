@@ -7,18 +7,20 @@
 #include <cryptopp/hex.h>  // For encoding the hash to hex (optional)
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
 #include <ctime> //time
+#include "rsakey.h"
 
 using namespace CryptoPP;
 
-void Sign(const std::string& privKeyFile, const std::string& dataFile, const std::string& signatureFile) {
-    // Read private key (d, n) from the binary file
-    Integer d, n;
-    FileSource privFile(privKeyFile.c_str(), true);
-   // This line decodes the public exponent d from the file using the Basic Encoding Rules (BER) format
-    d.BERDecode(privFile);
-    //This line decodes the public exponent n from the file using the Basic Encoding Rules (BER) format
-    n.BERDecode(privFile);
+void Sign(const std::string& privKeyFile, const std::string& dataFile, const std::string& signatureFile,
+          bool parallelCrt) {
+    // Read private key (d, n) from the binary file, plus the CRT fields (p, q, dP, dQ, qInv) if present.
+    // The fields are decoded using the Basic Encoding Rules (BER) format
+    RsaPrivateKey key = LoadPrivateKey(privKeyFile);
+    const Integer& n = key.n;
 
     // Read plaintext message from dataFile
     std::ifstream inFile(dataFile);
@@ -32,10 +34,8 @@ void Sign(const std::string& privKeyFile, const std::string& dataFile, const std
     inFile.close();
 
     // Signing parth
-    clock_t startTime, endTime; //time
-    double elapsed_time; //time
-    double avgTimeTaken, totalTimeTaken = 0.0; //time
-    startTime = clock();
+    // Wall-clock time: clock() would add up the CPU time of the per-prime threads
+    auto startTime = std::chrono::steady_clock::now(); //time
 
     // Hash the message using SHA-256
     byte hash[SHA256::DIGESTSIZE];//A byte array named hash is declared to 32Bytes constant
@@ -53,12 +53,10 @@ void Sign(const std::string& privKeyFile, const std::string& dataFile, const std
         return;
     }
 
-    // Perform signing: signature = h(m)^d mod n
-    Integer signature = a_exp_b_mod_c(h, d, n);
-    endTime = clock();
-    elapsed_time = static_cast<double>(endTime - startTime)/CLOCKS_PER_SEC*1000;
-    totalTimeTaken = (totalTimeTaken + elapsed_time);
-    // avgTimeTaken = (totalTimeTaken / n);
+    // Perform signing: signature = h(m)^d mod n (by CRT when the key has p and q, with the
+    // halves on two cores when parallelCrt is set)
+    Integer signature = RsaPrivateOp(key, h, parallelCrt);
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count(); //time
     std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
     
     // Write signature to binary file
@@ -67,13 +65,51 @@ void Sign(const std::string& privKeyFile, const std::string& dataFile, const std
     sigSink.MessageEnd();
 }
 
+// Batch mode: the key is read and its engines set up once, then all lines of the messages
+// file are signed together, several per vector operation; the signature file holds one
+// DER-encoded signature per line
+void SignBatch(const std::string& privKeyFile, const std::string& messagesFile, const std::string& signatureFile) {
+    RsaPrivateContext priv(LoadPrivateKey(privKeyFile));
+    std::ifstream in(messagesFile);
+    FileSink sigSink(signatureFile.c_str());
+
+    auto startTime = std::chrono::steady_clock::now(); //time
+    std::vector<Integer> digests;
+    std::string message;
+    while (std::getline(in, message)) {
+        byte hash[SHA256::DIGESTSIZE];
+        SHA256().CalculateDigest(hash, (const byte*)message.data(), message.size());
+        digests.push_back(Integer(hash, sizeof(hash)));
+    }
+    size_t count = digests.size();
+    for (const Integer& signature : priv.ApplyAll(digests)) {
+        signature.DEREncode(sigSink);
+    }
+    sigSink.MessageEnd();
+    double totalTimeTaken = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Execution Cost = " << totalTimeTaken << " ms" << std::endl;
+    std::cout << count << " messages signed (" << count / (totalTimeTaken / 1000) << " ops/s, " << priv.BatchKernel()
+              << ")" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc == 4 && std::string(argv[1]) == "--batch") {
+        SignBatch(argv[2], argv[3], "sign.bin");
+        return 0;
+    }
+    // --parallel-crt runs the two CRT exponentiations on two cores (persistent thread pool)
+    bool parallelCrt = argc > 1 && std::string(argv[1]) == "--parallel-crt";
+    if (parallelCrt) {
+        argv++;
+        argc--;
+    }
     if (argc != 3) {
-        std::cerr << "Usage: ./sign <private_key_file> <data_file>\n";
+        std::cerr << "Usage: ./sign [--parallel-crt] <private_key_file> <data_file>\n"
+                  << "       ./sign --batch <private_key_file> <messages_file>\n";
         return 1;
     }
 
-    Sign(argv[1], argv[2], "sign.bin");
+    Sign(argv[1], argv[2], "sign.bin", parallelCrt);
     return 0;
 }
 
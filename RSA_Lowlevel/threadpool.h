@@ -0,0 +1,90 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+// Small persistent thread pool for splitting one private-key operation across cores (the CRT
+// exponentiations of rsakey.h). Starting threads for every operation costs tens of
+// microseconds and touches cold stacks; these threads are started once and wait on a
+// condition variable between operations. RunAll may be called from several threads at once.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads) {
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([this] { Worker(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) {
+            t.join();
+        }
+    }
+
+    // Function to run tasks[0] on the calling thread and the others on pool threads; returns
+    // when all of them have finished. A pool without threads runs them all on the caller.
+    void RunAll(const std::vector<std::function<void()>>& tasks) {
+        if (tasks.empty()) return;
+        if (workers.empty()) {
+            for (const std::function<void()>& task : tasks) task();
+            return;
+        }
+        size_t remaining = tasks.size() - 1;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (size_t i = 1; i < tasks.size(); i++) {
+                const std::function<void()>* task = &tasks[i];
+                queue.push_back([this, task, &remaining] {
+                    (*task)();
+                    std::lock_guard<std::mutex> done(lock);
+                    if (--remaining == 0) finished.notify_all();
+                });
+            }
+        }
+        wake.notify_all();
+        tasks[0]();
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [&] { return remaining == 0; });
+    }
+
+private:
+    void Worker() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;  // stopping
+            std::function<void()> task = std::move(queue.front());
+            queue.pop_front();
+            guard.unlock();
+            task();
+            guard.lock();
+        }
+    }
+
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    std::deque<std::function<void()>> queue;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+// Pool used by the CRT private operations: up to three helper threads, enough for the four
+// exponentiations of a 4-prime key with the calling thread doing one of them, and none on a
+// single-core machine, where splitting would only add thread switches
+inline ThreadPool& CrtThreadPool() {
+    static ThreadPool pool(std::min(3u, std::max(1u, std::thread::hardware_concurrency()) - 1));
+    return pool;
+}
+
+#endif